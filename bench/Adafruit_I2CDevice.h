@@ -0,0 +1,3 @@
+#pragma once
+
+// Adafruit_GFX.h includes this but nothing in this project talks to a device through it.
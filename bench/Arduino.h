@@ -0,0 +1,45 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core that the libraries in this project use.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "Print.h"
+#include "pgmspace.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+class __FlashStringHelper;
+#define F(string) ((const __FlashStringHelper*)(string))
+
+class String : public std::string {
+public:
+    using std::string::string;
+    String(const std::string& string)
+        : std::string(string)
+    {
+    }
+};
+
+/**
+ * Logs are dropped on the host so they don't end up in the measurements.
+ */
+class HardwareSerial : public Print {
+public:
+    size_t write(uint8_t c) override
+    {
+        return 1;
+    }
+};
+
+inline HardwareSerial Serial;
+
+inline uint32_t esp_log_timestamp()
+{
+    return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdint.h>
+
+// Host stand-in for the few FreeRTOS task functions used in include/util.h.
+// Tasks run to completion right away since nothing on the host waits for them.
+
+typedef unsigned int UBaseType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define CONFIG_ARDUINO_LOOP_STACK_SIZE 8192
+
+inline int xTaskCreate(TaskFunction_t task, const char* name, uint32_t stackSize, void* parameters, UBaseType_t priority, TaskHandle_t* handle)
+{
+    task(parameters);
+    return 1;
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return nullptr;
+}
+
+inline void vTaskDelete(TaskHandle_t task)
+{
+}
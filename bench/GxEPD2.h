@@ -0,0 +1,7 @@
+#pragma once
+
+// the colors of GxEPD2, the canvas only needs those on the host
+#define GxEPD_BLACK 0x0000
+#define GxEPD_WHITE 0xFFFF
+#define GxEPD_RED 0xF800
+#define GxEPD_YELLOW 0xFFE0
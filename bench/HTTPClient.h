@@ -0,0 +1,215 @@
+#pragma once
+
+// Host stand-in for the HTTPClient of the esp32 arduino core.
+// It speaks plain http 1.0 over a socket, with the same collectHeaders and header semantics,
+// so the requests of the project can be sent to a server on the loopback interface.
+
+#include <arpa/inet.h>
+#include <strings.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Arduino.h"
+#include "Stream.h"
+
+enum {
+    HTTPC_ERROR_CONNECTION_REFUSED = -1,
+    HTTPC_ERROR_SEND_HEADER_FAILED = -2,
+    HTTPC_ERROR_CONNECTION_LOST = -5,
+};
+
+enum t_http_codes {
+    HTTP_CODE_OK = 200,
+    HTTP_CODE_NOT_MODIFIED = 304,
+};
+
+/**
+ * The body of the response, read straight from the socket.
+ */
+class SocketStream : public Stream {
+public:
+    int available() override
+    {
+        int count = 0;
+        return socket >= 0 && ioctl(socket, FIONREAD, &count) == 0 ? count : 0;
+    }
+
+    int read() override
+    {
+        char c;
+        return socket >= 0 && recv(socket, &c, 1, 0) == 1 ? (uint8_t)c : -1;
+    }
+
+    int peek() override
+    {
+        char c;
+        return socket >= 0 && recv(socket, &c, 1, MSG_PEEK) == 1 ? (uint8_t)c : -1;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        size_t count = 0;
+        while (socket >= 0 && count < length) {
+            auto received = recv(socket, buffer + count, length - count, 0);
+            if (received <= 0) {
+                break;
+            }
+            count += received;
+        }
+        return count;
+    }
+
+    int socket = -1;
+};
+
+class HTTPClient {
+public:
+    ~HTTPClient() { end(); }
+
+    /**
+     * Only http urls with a numeric host are supported, like http://127.0.0.1:8080/calender.ics
+     */
+    bool begin(const char* url)
+    {
+        end();
+        headers.clear();
+        requestHeaders.clear();
+
+        const char* scheme = "http://";
+        if (strncmp(url, scheme, strlen(scheme)) != 0) {
+            return false;
+        }
+        const char* hostStart = url + strlen(scheme);
+        const char* pathStart = strchr(hostStart, '/');
+        host.assign(hostStart, pathStart != nullptr ? pathStart - hostStart : strlen(hostStart));
+        path = pathStart != nullptr ? pathStart : "/";
+        port = 80;
+        auto colon = host.find(':');
+        if (colon != std::string::npos) {
+            port = atoi(host.c_str() + colon + 1);
+            host.resize(colon);
+        }
+        return true;
+    }
+
+    void useHTTP10(bool use) { http10 = use; }
+
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount)
+    {
+        headers.clear();
+        for (size_t i = 0; i < headerKeysCount; ++i) {
+            headers.push_back({ headerKeys[i], "" });
+        }
+    }
+
+    void addHeader(const String& name, const String& value)
+    {
+        requestHeaders += name + ": " + value + "\r\n";
+    }
+
+    int GET()
+    {
+        stream.socket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (stream.socket < 0 || inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1
+            || connect(stream.socket, (sockaddr*)&address, sizeof(address)) != 0) {
+            end();
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+
+        std::string request = "GET " + path + (http10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+        request += "Host: " + host + "\r\n";
+        request += "User-Agent: ESP32HTTPClient\r\n";
+        request += "Connection: close\r\n";
+        if (!http10) {
+            request += "Accept-Encoding: identity;q=1,chunked;q=0.1,*;q=0\r\n";
+        }
+        request += requestHeaders + "\r\n";
+        if (send(stream.socket, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+            end();
+            return HTTPC_ERROR_SEND_HEADER_FAILED;
+        }
+
+        // the status line and the headers, only the collected ones are kept
+        char line[512];
+        const char* code = readLine(line, sizeof(line)) ? strchr(line, ' ') : nullptr;
+        int status = code != nullptr ? atoi(code + 1) : HTTPC_ERROR_CONNECTION_LOST;
+        while (status > 0 && readLine(line, sizeof(line)) && line[0] != '\0') {
+            const char* colon = strchr(line, ':');
+            if (colon == nullptr) {
+                continue;
+            }
+            for (auto& header : headers) {
+                if (header.first.size() == (size_t)(colon - line) && strncasecmp(line, header.first.c_str(), colon - line) == 0) {
+                    const char* value = colon + 1;
+                    while (*value == ' ') {
+                        value++;
+                    }
+                    header.second = value;
+                }
+            }
+        }
+
+        if (status <= 0) {
+            end();
+        }
+        return status;
+    }
+
+    String header(const char* name)
+    {
+        for (auto& header : headers) {
+            if (strcasecmp(header.first.c_str(), name) == 0) {
+                return header.second;
+            }
+        }
+        return String();
+    }
+
+    Stream* getStreamPtr() { return stream.socket >= 0 ? &stream : nullptr; }
+
+    void end()
+    {
+        if (stream.socket >= 0) {
+            close(stream.socket);
+            stream.socket = -1;
+        }
+    }
+
+private:
+    /**
+     * Reads a line without the line break, longer lines are cut. Returns false if the connection ended before it.
+     */
+    bool readLine(char* line, size_t size)
+    {
+        size_t length = 0;
+        while (true) {
+            int c = stream.read();
+            if (c < 0) {
+                line[length] = '\0';
+                return false;
+            }
+            if (c == '\n') {
+                break;
+            }
+            if (c != '\r' && length < size - 1) {
+                line[length++] = c;
+            }
+        }
+
+        line[length] = '\0';
+        return true;
+    }
+
+    std::string host;
+    std::string path;
+    uint16_t port = 80;
+    bool http10 = false;
+    std::string requestHeaders;
+    std::vector<std::pair<std::string, String>> headers;
+    SocketStream stream;
+};
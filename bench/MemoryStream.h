@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+
+#include "Stream.h"
+
+/**
+ * A Stream that serves a string from memory, like a http response that is already fully received.
+ */
+class MemoryStream : public Stream {
+public:
+    explicit MemoryStream(const std::string& content)
+        : content(content)
+    {
+    }
+
+    int available() override
+    {
+        return content.size() - position;
+    }
+
+    int read() override
+    {
+        return position < content.size() ? (uint8_t)content[position++] : -1;
+    }
+
+    int peek() override
+    {
+        return position < content.size() ? (uint8_t)content[position] : -1;
+    }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        // like WiFiClient this copies as much as possible at once
+        size_t count = std::min(length, content.size() - position);
+        memcpy(buffer, content.data() + position, count);
+        position += count;
+        return count;
+    }
+
+private:
+    const std::string& content;
+    size_t position = 0;
+};
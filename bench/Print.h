@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+class Print {
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t count = 0;
+        while (size--) {
+            count += write(*buffer++);
+        }
+        return count;
+    }
+
+    size_t write(const char* string)
+    {
+        return write((const uint8_t*)string, strlen(string));
+    }
+
+    size_t print(const char* string)
+    {
+        return write(string);
+    }
+
+    size_t print(char c)
+    {
+        return write((uint8_t)c);
+    }
+
+    size_t println()
+    {
+        return write("\r\n");
+    }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        int length = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return write((const uint8_t*)buffer, length < (int)sizeof(buffer) ? length : sizeof(buffer) - 1);
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+// Host stand-in for the Arduino Stream class.
+// It only implements the parts the libraries in this project use.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "probe.h"
+
+class Stream {
+public:
+    virtual ~Stream() = default;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(char* buffer, size_t length)
+    {
+        size_t count = 0;
+        while (count < length) {
+            int c = read();
+            if (c < 0) {
+                break;
+            }
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+
+    size_t readBytesUntil(char terminator, char* buffer, size_t length)
+    {
+        probeCounters.readBytesUntil++;
+
+        // same semantics as the arduino implementation:
+        // the terminator is consumed but not stored and the line is cut at length
+        size_t count = 0;
+        while (count < length) {
+            int c = read();
+            if (c < 0 || c == terminator) {
+                break;
+            }
+            buffer[count++] = (char)c;
+        }
+        return count;
+    }
+};
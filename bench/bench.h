@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <stdio.h>
+#include <string>
+
+#include "probe.h"
+
+/**
+ * Returns the path of a file in the fixture directory.
+ */
+std::string fixturePath(const char* name);
+
+/**
+ * Returns the path of a file in the output directory, which is created if it doesn't exist.
+ * Everything the benchmark writes goes there instead of into the fixtures.
+ */
+std::string outputPath(const char* name);
+
+/**
+ * Reads a file from the fixture directory.
+ * The program is stopped if the fixture can't be read since all numbers would be meaningless.
+ */
+std::string loadFixture(const char* name);
+
+/**
+ * Prints the message and counts a failure if the condition doesn't hold, the benchmark then exits with 1.
+ * Returns the condition.
+ */
+bool expect(bool condition, const char* format, ...);
+
+/**
+ * Runs the function repeatedly for at least the given duration and returns the average nanoseconds per run.
+ */
+template <typename F>
+double measureNanos(F func, double minSeconds = 0.5)
+{
+    using clock = std::chrono::steady_clock;
+    unsigned long runs = 0;
+    auto start = clock::now();
+    std::chrono::duration<double> elapsed;
+    do {
+        func();
+        runs++;
+        elapsed = clock::now() - start;
+    } while (elapsed.count() < minSeconds);
+
+    return elapsed.count() * 1e9 / runs;
+}
+
+void benchICal();
+void benchTopList();
+void benchDither();
+void benchCanvas();
+void benchRender();
+void benchCivil();
+void benchSources();
+void benchPipeline();
+void benchSnapshot();
+void benchInflate();
+void benchSchedule();
+void benchVoltage();
+void benchReconnect();
+void benchTimeSource();
+void benchConditionalGet();
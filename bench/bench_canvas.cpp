@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <string.h>
+
+#include "bench.h"
+#include "canvas.h"
+
+typedef Canvas3C<400, 300> Canvas;
+
+/**
+ * Draws the same thing through Adafruit_GFX (pixel by pixel) and through the canvas (byte by byte).
+ * The canvas has to be at least minSpeedup times faster in every rotation.
+ */
+template <typename F>
+static void benchDraw(const char* name, double minSpeedup, F draw)
+{
+    static Canvas pixelCanvas, spanCanvas;
+    size_t differences = 0;
+    double pixelNanos = 0, spanNanos = 0;
+    double speedups[4];
+    for (uint8_t rotation = 0; rotation < 4; ++rotation) {
+        pixelCanvas.setRotation(rotation);
+        spanCanvas.setRotation(rotation);
+        pixelCanvas.fillScreen(GxEPD_WHITE);
+        spanCanvas.fillScreen(GxEPD_WHITE);
+        pixelCanvas.fillRect(0, 0, pixelCanvas.width() / 2, pixelCanvas.height(), GxEPD_BLACK);
+        spanCanvas.fillRect(0, 0, spanCanvas.width() / 2, spanCanvas.height(), GxEPD_BLACK);
+
+        draw(static_cast<Adafruit_GFX&>(pixelCanvas));
+        draw(spanCanvas);
+        for (size_t i = 0; i < Canvas::BUFFER_SIZE; ++i) {
+            differences += pixelCanvas.blackBuffer[i] != spanCanvas.blackBuffer[i];
+            differences += pixelCanvas.colorBuffer[i] != spanCanvas.colorBuffer[i];
+        }
+
+        // the fastest of many single draws, taken in turns, so the speedup isn't missed because something else ran in between
+        double pixel = 1e12, span = 1e12;
+        for (int run = 0; run < 200; ++run) {
+            pixel = std::min(pixel, measureNanos([&]() { draw(static_cast<Adafruit_GFX&>(pixelCanvas)); }, 0));
+            span = std::min(span, measureNanos([&]() { draw(spanCanvas); }, 0));
+        }
+        pixelNanos += pixel;
+        spanNanos += span;
+        speedups[rotation] = pixel / span;
+        expect(speedups[rotation] >= minSpeedup, "%s is only %.1fx faster in rotation %u", name, speedups[rotation], rotation);
+    }
+
+    printf("%-18s pixel %8.1f us   span %8.1f us   %5.1fx %5.1fx %5.1fx %5.1fx   %zu different bytes\n",
+        name, pixelNanos / 4000, spanNanos / 4000, speedups[0], speedups[1], speedups[2], speedups[3], differences);
+    expect(differences == 0, "%s differs in %zu bytes", name, differences);
+}
+
+// the header bars and the fade have to be at least an order of magnitude faster than drawPixel
+void benchCanvas()
+{
+    printf("\ncanvas\n");
+    benchDraw("header 3C", 10, [](auto& canvas) {
+        drawGradientX(canvas, { 0, 13 }, { canvas.width(), 55 }, COLORSPACE_3C, GxEPD_BLACK, GxEPD_RED);
+    });
+    benchDraw("header 2C", 10, [](auto& canvas) {
+        drawGradientX(canvas, { 0, 13 }, { canvas.width(), 55 }, COLORSPACE_2C, GxEPD_BLACK, mix(GxEPD_BLACK, GxEPD_WHITE, 128));
+    });
+    benchDraw("gradient y", 10, [](auto& canvas) {
+        drawGradientY(canvas, { 3, 5 }, { 101, 200 }, COLORSPACE_3C, GxEPD_RED, GxEPD_WHITE);
+    });
+    benchDraw("fade", 10, [](auto& canvas) {
+        drawFadeY(canvas, { 0, (int16_t)(canvas.height() - 64) }, { canvas.width(), 64 }, COLORSPACE_2C, GxEPD_BLACK, mix(GxEPD_BLACK, GxEPD_WHITE, 170));
+    });
+    benchDraw("rect clipped", 10, [](auto& canvas) {
+        drawRect(canvas, { -5, -7 }, { 50, 500 }, COLORSPACE_2C, mix(GxEPD_BLACK, GxEPD_WHITE, 100));
+    });
+}
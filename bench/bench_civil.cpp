@@ -0,0 +1,95 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+#include "civil.h"
+
+static const int64_t FIRST_DAY = daysFromCivil(CIVIL_FIRST_YEAR, 1, 1);
+static const int64_t LAST_DAY = daysFromCivil(CIVIL_LAST_YEAR, 12, 31);
+
+/**
+ * Compares every day and every hour from 1970 to 2200 with glibc, with the same rules as a TZ string.
+ */
+static void compareWithLibc()
+{
+    size_t dateDifferences = 0, localDifferences = 0, mktimeDifferences = 0;
+    for (int64_t days = FIRST_DAY; days <= LAST_DAY; ++days) {
+        time_t time = days * 86400;
+        tm expected;
+        gmtime_r(&time, &expected);
+        auto date = civilFromDays(days);
+        dateDifferences += date.year != expected.tm_year + 1900
+            || date.month != expected.tm_mon + 1
+            || date.day != expected.tm_mday
+            || weekdayFromDays(days) != expected.tm_wday
+            || daysFromCivil(date.year, date.month, date.day) != days;
+
+        tm midnight = {};
+        midnight.tm_year = date.year - 1900;
+        midnight.tm_mon = date.month - 1;
+        midnight.tm_mday = date.day;
+        midnight.tm_isdst = -1;
+        mktimeDifferences += fromLocalTime(date.year, date.month, date.day) != mktime(&midnight);
+
+        for (int64_t hour = 0; hour < 24; ++hour) {
+            time_t time = days * 86400 + hour * 3600 + 1234;
+            localtime_r(&time, &expected);
+            auto local = toLocalTime(time);
+            localDifferences += local.date.year != expected.tm_year + 1900
+                || local.date.month != expected.tm_mon + 1
+                || local.date.day != expected.tm_mday
+                || local.weekday != expected.tm_wday
+                || local.hour != expected.tm_hour
+                || local.minute != expected.tm_min
+                || local.second != expected.tm_sec;
+        }
+    }
+
+    printf("%lld days compared with glibc: %zu civil dates, %zu local times, %zu local midnights differ\n",
+        (long long)(LAST_DAY - FIRST_DAY + 1), dateDifferences, localDifferences, mktimeDifferences);
+}
+
+void benchCivil()
+{
+    setenv("TZ", "CET-1CEST,M3.5.0,M10.5.0/3", 1);
+    tzset();
+    setTimeZone(3600, 3600);
+
+    printf("\ncivil dates\n");
+    compareWithLibc();
+
+    // a year of daily timestamps, like the entries of a calender
+    const int64_t from = daysFromCivil(2021, 1, 1) * 86400 + 12 * 3600;
+    volatile int32_t sink;
+    auto localtimeNanos = measureNanos([&]() {
+        for (int64_t day = 0; day < 365; ++day) {
+            time_t time = from + day * 86400;
+            tm result;
+            localtime_r(&time, &result);
+            sink = result.tm_mday;
+        }
+    });
+    auto localNanos = measureNanos([&]() {
+        for (int64_t day = 0; day < 365; ++day) {
+            sink = toLocalTime(from + day * 86400).date.day;
+        }
+    });
+    auto mktimeNanos = measureNanos([&]() {
+        for (int day = 1; day <= 365; ++day) {
+            tm date = {};
+            date.tm_year = 121;
+            date.tm_mday = day;
+            date.tm_isdst = -1;
+            sink = mktime(&date);
+        }
+    });
+    auto fromLocalNanos = measureNanos([&]() {
+        for (int day = 1; day <= 365; ++day) {
+            sink = fromLocalTime(2021, 1, day);
+        }
+    });
+    (void)sink;
+
+    printf("localtime_r %6.1f ns/call   toLocalTime   %6.1f ns/call\n", localtimeNanos / 365, localNanos / 365);
+    printf("mktime      %6.1f ns/call   fromLocalTime %6.1f ns/call\n", mktimeNanos / 365, fromLocalNanos / 365);
+}
@@ -0,0 +1,368 @@
+#include <arpa/inet.h>
+#include <mutex>
+#include <string.h>
+#include <string>
+#include <strings.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "bench.h"
+#include "conditionalGet.h"
+
+/**
+ * A server with a calender that changes when its version does, and the cache of the device.
+ * Every request is recorded as its kind and the status, like "cond304 get200".
+ */
+class FakeServer : public CachedResource {
+public:
+    int request(const char* ifNoneMatch, const char* ifModifiedSince) override
+    {
+        open++;
+        char eTag[16], lastModified[32];
+        snprintf(eTag, sizeof(eTag), "\"v%d\"", version);
+        snprintf(lastModified, sizeof(lastModified), "Mon, %02d Jan 2021 06:00:00 GMT", version);
+
+        int status = 200;
+        if (!online) {
+            status = -1;
+        } else if (ignoresValidators) {
+            status = 304;
+        } else if (ifNoneMatch != nullptr) {
+            status = sendsETag && strcmp(ifNoneMatch, eTag) == 0 ? 304 : 200;
+        } else if (ifModifiedSince != nullptr) {
+            status = strcmp(ifModifiedSince, lastModified) == 0 ? 304 : 200;
+        }
+
+        requests += requests.empty() ? "" : " ";
+        requests += ifNoneMatch != nullptr || ifModifiedSince != nullptr ? "cond" : "get";
+        requests += ifNoneMatch != nullptr ? "E" : "";
+        requests += ifModifiedSince != nullptr ? "M" : "";
+        requests += std::to_string(status);
+        return status;
+    }
+
+    bool loadCached() override
+    {
+        return cacheLeft;
+    }
+
+    bool readBody(HttpValidators& validators) override
+    {
+        if (breaksOff) {
+            return false;
+        }
+
+        snprintf(validators.eTag, sizeof(validators.eTag), sendsETag ? "\"v%d\"" : "", version);
+        snprintf(validators.lastModified, sizeof(validators.lastModified), "Mon, %02d Jan 2021 06:00:00 GMT", version);
+        cacheLeft = true;
+        return true;
+    }
+
+    void finish() override
+    {
+        open--;
+    }
+
+    int version = 1;
+    bool online = true;
+    bool sendsETag = true;
+    bool ignoresValidators = false; // answers everything with a 304
+    bool breaksOff = false;
+    bool cacheLeft = false; // if enough cached entries are left
+    int open = 0;
+    std::string requests;
+};
+
+/**
+ * Runs one download and compares the requests and the validators that are kept afterwards.
+ */
+static void scenario(const char* name, FakeServer& server, HttpValidators& validators, const char* expected, int expectedStatus, bool expectValidators)
+{
+    server.requests.clear();
+    int status = conditionalGet(server, validators);
+    bool kept = validators.eTag[0] != '\0' || validators.lastModified[0] != '\0';
+    bool ok = server.requests == expected && status == expectedStatus && kept == expectValidators && server.open == 0;
+    expect(ok, "%s: %s -> %d%s, expected %s -> %d%s", name, server.requests.c_str(), status, kept ? " kept" : "", expected, expectedStatus, expectValidators ? " kept" : "");
+
+    printf("%-28s %-22s %4d   %-10s %s\n", name, server.requests.c_str(), status, kept ? "validators" : "-", ok ? "ok" : "UNEXPECTED");
+}
+
+/**
+ * A calender server on the loopback interface for the http side of the download.
+ * It answers a matching If-None-Match or If-Modified-Since with a 304 and everything else with the calender,
+ * both with ETag, Last-Modified and Date. The requests are recorded like the ones of FakeServer.
+ */
+class LoopbackServer {
+public:
+    LoopbackServer()
+    {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0
+            || getsockname(listener, (sockaddr*)&address, &length) != 0) {
+            expect(false, "loopback server can't listen");
+            return;
+        }
+
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d/calender.ics", ntohs(address.sin_port));
+        thread = std::thread([this]() {
+            int connection;
+            while ((connection = accept(listener, nullptr, nullptr)) >= 0) {
+                answer(connection);
+                close(connection);
+            }
+        });
+    }
+
+    ~LoopbackServer()
+    {
+        stop();
+    }
+
+    /**
+     * Stops answering, connections to the url are refused afterwards.
+     */
+    void stop()
+    {
+        if (listener < 0) {
+            return;
+        }
+
+        // makes accept return, so the thread ends
+        shutdown(listener, SHUT_RDWR);
+        if (thread.joinable()) {
+            thread.join();
+        }
+        close(listener);
+        listener = -1;
+    }
+
+    std::string eTag()
+    {
+        return "\"v" + std::to_string(version) + "\"";
+    }
+
+    std::string lastModified()
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "Mon, %02d Jan 2021 06:00:00 GMT", version);
+        return text;
+    }
+
+    char url[64] = "";
+    int version = 1;
+    bool sendsETag = true;
+    std::string plain; // the body of a 200
+    std::string gzip; // the body of a 200 if gzip is accepted
+    std::string date; // of the last response
+    std::string requests;
+    std::mutex lock;
+
+private:
+    /**
+     * Returns the value of the header in the request, nullptr if it wasn't sent.
+     */
+    static const char* findHeader(const std::string& request, const char* name, std::string& value)
+    {
+        for (size_t line = request.find("\r\n"); line != std::string::npos && line + 2 < request.size(); line = request.find("\r\n", line + 2)) {
+            size_t start = line + 2;
+            size_t colon = request.find(':', start);
+            if (colon != std::string::npos && colon - start == strlen(name) && strncasecmp(request.c_str() + start, name, colon - start) == 0) {
+                size_t end = request.find("\r\n", colon);
+                value = request.substr(colon + 2, end - colon - 2);
+                return value.c_str();
+            }
+        }
+
+        return nullptr;
+    }
+
+    void answer(int connection)
+    {
+        std::string request;
+        char buffer[512];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            auto received = recv(connection, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                return;
+            }
+            request.append(buffer, received);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        std::string ifNoneMatch, ifModifiedSince, acceptEncoding;
+        bool eTagSent = findHeader(request, "If-None-Match", ifNoneMatch) != nullptr;
+        bool modifiedSent = findHeader(request, "If-Modified-Since", ifModifiedSince) != nullptr;
+        bool gzipAccepted = findHeader(request, "Accept-Encoding", acceptEncoding) != nullptr && acceptEncoding == "gzip";
+
+        // If-None-Match wins over If-Modified-Since, like rfc 7232 says
+        bool notModified = eTagSent ? sendsETag && ifNoneMatch == eTag() : modifiedSent && ifModifiedSince == lastModified();
+        const std::string requestLine = "GET /calender.ics HTTP/1.0\r\n";
+        int status = request.compare(0, requestLine.size(), requestLine) != 0 ? 400 : notModified ? 304 : 200;
+
+        requests += requests.empty() ? "" : " ";
+        requests += eTagSent || modifiedSent ? "cond" : "get";
+        requests += eTagSent ? "E" : "";
+        requests += modifiedSent ? "M" : "";
+        requests += std::to_string(status);
+        requests += gzipAccepted && status == 200 ? "gz" : "";
+
+        char dateText[32];
+        snprintf(dateText, sizeof(dateText), "Mon, 04 Jan 2021 05:%02d:00 GMT", (int)(responses++ % 60));
+        date = dateText;
+
+        const std::string& body = gzipAccepted ? gzip : plain;
+        std::string response = status == 304 ? "HTTP/1.1 304 Not Modified\r\n" : status == 200 ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 400 Bad Request\r\n";
+        response += "Server: loopback\r\n";
+        response += "date: " + date + "\r\n"; // header names are case insensitive
+        response += sendsETag ? "ETag: " + eTag() + "\r\n" : "";
+        response += "Last-Modified: " + lastModified() + "\r\n";
+        response += "Cache-Control: max-age=0\r\n";
+        response += "Connection: close\r\n";
+        if (status == 200) {
+            response += gzipAccepted ? "Content-Encoding: gzip\r\n" : "";
+            response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        } else {
+            response += "\r\n";
+        }
+        send(connection, response.data(), response.size(), MSG_NOSIGNAL);
+    }
+
+    int listener = -1;
+    std::thread thread;
+    uint32_t responses = 0;
+};
+
+/**
+ * The http side of a download with the cache as a string, the body has to be the one the server sent.
+ */
+class LoopbackDownload : public HttpResource {
+public:
+    LoopbackDownload(const char* url, bool acceptGzip, LoopbackServer& server, std::string& cache)
+        : HttpResource(url, acceptGzip)
+        , server(server)
+        , cache(cache)
+    {
+    }
+
+    int request(const char* ifNoneMatch, const char* ifModifiedSince) override
+    {
+        int status = HttpResource::request(ifNoneMatch, ifModifiedSince);
+        date = HttpResource::date();
+        return status;
+    }
+
+    bool loadCached() override
+    {
+        return !cache.empty();
+    }
+
+    bool readBody(HttpValidators& validators) override
+    {
+        std::string body;
+        char buffer[256];
+        Stream* stream = http.getStreamPtr();
+        while (size_t length = stream != nullptr ? stream->readBytes(buffer, sizeof(buffer)) : 0) {
+            body.append(buffer, length);
+        }
+
+        gzip = isGzip();
+        if (body != (gzip ? server.gzip : server.plain)) {
+            return false;
+        }
+
+        cache = body;
+        keepValidators(validators);
+        return true;
+    }
+
+    String date;
+    bool gzip = false;
+
+private:
+    LoopbackServer& server;
+    std::string& cache;
+};
+
+/**
+ * Runs one download against the loopback server, the validators have to be the headers of the last 200
+ * and the date the one of the last response.
+ */
+static void loopbackScenario(const char* name, LoopbackServer& server, HttpValidators& validators, std::string& cache, bool acceptGzip,
+    const char* expected, int expectedStatus)
+{
+    server.requests.clear();
+    server.date.clear();
+    LoopbackDownload download(server.url, acceptGzip, server, cache);
+    int status = conditionalGet(download, validators);
+
+    std::lock_guard<std::mutex> guard(server.lock);
+    bool sameValidators = status != 200
+        || (validators.eTag == (server.sendsETag ? server.eTag() : "") && validators.lastModified == server.lastModified());
+    bool ok = server.requests == expected && status == expectedStatus && sameValidators && download.date == server.date
+        && download.gzip == (acceptGzip && status == 200);
+    expect(ok, "%s: %s -> %d (%s, %s, date %s), expected %s -> %d", name, server.requests.c_str(), status, validators.eTag, validators.lastModified,
+        download.date.c_str(), expected, expectedStatus);
+
+    printf("%-28s %-22s %4d   %-10s %s\n", name, server.requests.c_str(), status, validators.eTag[0] != '\0' ? validators.eTag : "-", ok ? "ok" : "UNEXPECTED");
+}
+
+static void benchLoopback()
+{
+    LoopbackServer server;
+    server.plain = loadFixture("small.ics");
+    server.gzip = loadFixture("small.ics.gz");
+    HttpValidators validators = {};
+    std::string cache;
+
+    printf("\nconditional get (loopback server)\n");
+    loopbackScenario("first download", server, validators, cache, false, "get200", 200);
+    loopbackScenario("not modified", server, validators, cache, false, "condEM304", 304);
+    server.version++;
+    loopbackScenario("modified", server, validators, cache, false, "condEM200", 200);
+    server.version++;
+    server.sendsETag = false;
+    loopbackScenario("without ETag", server, validators, cache, false, "condEM200", 200);
+    loopbackScenario("only Last-Modified", server, validators, cache, false, "condM304", 304);
+    server.version++;
+    loopbackScenario("gzip", server, validators, cache, true, "condM200gz", 200);
+    cache.clear();
+    loopbackScenario("too few cached entries", server, validators, cache, false, "condM304 get200", 200);
+    server.stop();
+    loopbackScenario("offline", server, validators, cache, false, "", HTTPC_ERROR_CONNECTION_REFUSED);
+}
+
+void benchConditionalGet()
+{
+    FakeServer server;
+    HttpValidators validators = {};
+
+    printf("\nconditional get (fake server)\n");
+    scenario("first download", server, validators, "get200", 200, true);
+    scenario("not modified", server, validators, "condEM304", 304, true);
+    server.version++;
+    scenario("modified", server, validators, "condEM200", 200, true);
+    server.cacheLeft = false;
+    scenario("too few cached entries", server, validators, "condEM304 get200", 200, true);
+    server.online = false;
+    scenario("offline", server, validators, "condEM-1", -1, true);
+    server.online = true;
+    server.version++;
+    server.breaksOff = true;
+    scenario("download breaks off", server, validators, "condEM200", 200, false);
+    server.breaksOff = false;
+    scenario("after the break", server, validators, "get200", 200, true);
+    server.sendsETag = false;
+    server.version++;
+    scenario("without ETag", server, validators, "condEM200", 200, true);
+    scenario("only Last-Modified", server, validators, "condM304", 304, true);
+    server.cacheLeft = false;
+    server.ignoresValidators = true;
+    scenario("304 to everything", server, validators, "condM304 get304", 304, true);
+
+    benchLoopback();
+}
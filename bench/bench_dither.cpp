@@ -0,0 +1,76 @@
+#include <vector>
+
+#include "bench.h"
+#include "dither.h"
+
+// the dither implementation that was used before the precomputed palettes, kept as reference
+static const color_t LEGACY_2C[] = { 0x0000, 0xFFFF };
+static const color_t LEGACY_3C[] = { 0x0000, 0xF800, 0xFFFF };
+
+static color_t legacyDither(xy_t pos, const color_t* palette, color_t color)
+{
+    uint16_t lowDistance = 0xFFFF;
+    color_t lowColor = 0x0000;
+    uint16_t highDistance = 0xFFFF;
+    color_t highColor = 0xFFFF;
+
+    size_t i = 0;
+    auto colorBrightness = brightness(color);
+    do {
+        auto brightnessDistance = brightness(palette[i]) - colorBrightness;
+        if (brightnessDistance == 0) {
+            return palette[i];
+        } else if (brightnessDistance > 0 && highDistance > brightnessDistance) {
+            highDistance = brightnessDistance;
+            highColor = palette[i];
+        } else if (brightnessDistance < 0 && lowDistance > -brightnessDistance) {
+            lowDistance = -brightnessDistance;
+            lowColor = palette[i];
+        }
+    } while (palette[i++] != 0xFFFF);
+
+    auto threshold = lowDistance * DITHER_MAX / (lowDistance + highDistance);
+    return DITHER_PATTERN[pos.x % 8][pos.y % 8] > threshold ? lowColor : highColor;
+}
+
+template <size_t N>
+static void benchPalette(const char* name, const color_t* legacyPalette, const Palette<N>& palette, color_t c1, color_t c2)
+{
+    const xy_t size = { 400, 300 };
+
+    // a horizontal gradient like the header bars
+    std::vector<color_t> colors(size.x);
+    for (int16_t x = 0; x < size.x; ++x) {
+        colors[x] = mix(c1, c2, x * 255 / (size.x - 1));
+    }
+
+    size_t differences = 0;
+    loopRect({ 0, 0 }, size, [&](xy_t rel, xy_t abs) {
+        differences += legacyDither(abs, legacyPalette, colors[abs.x]) != dither(abs, palette, colors[abs.x]);
+    });
+
+    volatile color_t sink;
+    auto legacyNanos = measureNanos([&]() {
+        loopRect({ 0, 0 }, size, [&](xy_t rel, xy_t abs) {
+            sink = legacyDither(abs, legacyPalette, colors[abs.x]);
+        });
+    });
+    auto paletteNanos = measureNanos([&]() {
+        loopRect({ 0, 0 }, size, [&](xy_t rel, xy_t abs) {
+            sink = dither(abs, palette, colors[abs.x]);
+        });
+    });
+    (void)sink;
+
+    size_t pixels = size.x * size.y;
+    printf("%-18s legacy %6.2f ns/px   palette %6.2f ns/px   %zu different pixels\n",
+        name, legacyNanos / pixels, paletteNanos / pixels, differences);
+}
+
+void benchDither()
+{
+    printf("\ndither\n");
+    benchPalette("2C black-white", LEGACY_2C, COLORSPACE_2C, 0x0000, 0xFFFF);
+    benchPalette("3C black-red", LEGACY_3C, COLORSPACE_3C, 0x0000, 0xF800);
+    benchPalette("3C black-white", LEGACY_3C, COLORSPACE_3C, 0x0000, 0xFFFF);
+}
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <time.h>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+
+static const size_t LIST_SIZE = 8;
+
+struct ICalRun {
+    const std::string* content;
+    size_t events;
+    ICalResult result;
+};
+
+static std::string generateFeed(size_t events)
+{
+    const char* summaries[] = { "Restabfall (2-woechentlich)", "Bioabfall (2-woechentlich)", "Gelber Sack (2-woechentlich)", "Papier (4-woechentlich)" };
+
+    std::string feed = "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//Benchmark//Synthetic//EN\r\n";
+    tm date = {};
+    date.tm_year = 121;
+    date.tm_mday = 1;
+    date.tm_hour = 12;
+    for (size_t i = 0; i < events; ++i) {
+        date.tm_mday++;
+        timegm(&date); // normalize the date
+
+        char event[256];
+        snprintf(event, sizeof(event),
+            "BEGIN:VEVENT\r\nUID:synthetic-%zu\r\nDTSTAMP:20201201T120000Z\r\nDTSTART;VALUE=DATE:%04d%02d%02d\r\nSUMMARY:%s\r\nEND:VEVENT\r\n",
+            i, date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, summaries[i % 4]);
+        feed += event;
+    }
+
+    feed += "END:VCALENDAR\r\n";
+    return feed;
+}
+
+static void countEntries(void* parameters)
+{
+    auto run = (ICalRun*)parameters;
+    ICalParser parser;
+    auto data = run->content->data();
+    auto length = run->content->size();
+    size_t offset = 0;
+    run->events = 0;
+    do {
+        size_t consumed = 0;
+        run->result = offset < length ? parser.write(data + offset, length - offset, consumed) : parser.finish();
+        offset += consumed;
+        if (run->result == ICAL_OK) {
+            run->events++;
+        }
+    } while (run->result == ICAL_OK || (run->result == ICAL_NEED_MORE && offset < length));
+}
+
+static void readStream(void* parameters)
+{
+    auto run = (ICalRun*)parameters;
+    MemoryStream stream(*run->content);
+    ICalEntry list[LIST_SIZE];
+    size_t listSize = 0;
+    run->result = readICalStream(&stream, list, listSize, LIST_SIZE, 0);
+}
+
+static void benchFeed(const char* name, const std::string& content)
+{
+    ICalRun run = { &content, 0, ICAL_OK };
+
+    probeReset();
+    countEntries(&run);
+    auto counters = probeCounters;
+    auto events = run.events;
+
+    probeReset();
+    auto stack = probeStackPeak(readStream, &run);
+    auto heap = probeHeapPeak();
+    auto result = run.result;
+
+    auto nanos = measureNanos([&run]() { readStream(&run); });
+
+    printf("%-14s %8zu B %6zu ev %5s %10.0f us %8.2f MB/s %10.0f ev/s %6zu B stack %6zu B heap %7lu readBytesUntil %7lu sscanf %6lu mktime\n",
+        name,
+        content.size(),
+        events,
+        result == ICAL_END ? "ok" : "error",
+        nanos / 1e3,
+        content.size() / nanos * 1e3,
+        events / nanos * 1e9,
+        stack,
+        heap,
+        counters.readBytesUntil,
+        counters.sscanf,
+        counters.mktime);
+}
+
+/**
+ * Reads the fixture from firstDay on and compares the entries with the expected "YYYY-MM-DD summary" lines.
+ */
+static void expectEntries(const char* name, int32_t firstDay, const std::vector<std::string>& expected)
+{
+    auto content = loadFixture(name);
+    MemoryStream stream(content);
+    ICalEntry list[LIST_SIZE];
+    size_t listSize = 0;
+    auto result = readICalStream(&stream, list, listSize, LIST_SIZE, firstDay);
+
+    std::vector<std::string> actual;
+    for (size_t i = 0; i < listSize; ++i) {
+        auto date = civilFromDays(list[i].day);
+        char line[64];
+        snprintf(line, sizeof(line), "%04d-%02d-%02d %s", (int)date.year, date.month, date.day, icalSummary(list[i].summary));
+        actual.push_back(line);
+    }
+
+    bool ok = expect(result == ICAL_END && actual == expected, "%s entries differ", name);
+    printf("%-14s %zu entries %s\n", name, listSize, ok ? "as expected" : "DIFFER");
+    for (size_t i = 0; !ok && (i < actual.size() || i < expected.size()); ++i) {
+        printf("  %-32s %s\n", i < actual.size() ? actual[i].c_str() : "-", i < expected.size() ? expected[i].c_str() : "-");
+    }
+}
+
+void benchICal()
+{
+    // all dates are interpreted in the timezone of the device
+    setTimeZone(3600, 3600);
+
+    printf("iCal parser\n");
+    benchFeed("small", loadFixture("small.ics"));
+    benchFeed("awsh", loadFixture("awsh.ics"));
+    benchFeed("synthetic-10k", generateFeed(10000));
+    benchFeed("pathological", loadFixture("pathological.ics"));
+    benchFeed("recurring", loadFixture("recurring.ics"));
+
+    // the summaries and dates of nested components, like alarms, belong to the component and not the event
+    expectEntries("alarm.ics", daysFromCivil(2021, 1, 1), {
+        "2021-01-04 Restabfall",
+        "2021-01-05 Gelber Sack",
+        "2021-01-11 Bioabfall",
+        "2021-02-02 Gelber Sack",
+        "2021-02-16 Gelber Sack",
+    });
+    expectEntries("ordinals.ics", daysFromCivil(2021, 1, 1), {
+        "2021-01-04 Papier",
+        "2021-01-12 Sperrmuell",
+        "2021-01-18 Papier",
+        "2021-01-29 Sperrmuell",
+        "2021-02-01 Papier",
+        "2021-02-09 Sperrmuell",
+        "2021-02-15 Papier",
+        "2021-02-26 Sperrmuell",
+    });
+}
@@ -0,0 +1,112 @@
+#include <string>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+#include "inflate.h"
+#include "snapshot.h"
+
+static const size_t CALENDER_SIZE = 32;
+
+static std::string inflateAll(const std::string& compressed, bool& failed)
+{
+    MemoryStream source(compressed);
+    InflateStream* stream = new InflateStream(&source);
+    std::string content;
+    char buffer[256];
+    while (auto length = stream->readBytes(buffer, sizeof(buffer))) {
+        content.append(buffer, length);
+    }
+
+    failed = stream->failed();
+    delete stream;
+    return content;
+}
+
+/**
+ * Checks the output against the crc32 and size in the gzip trailer, so the fixtures don't need an uncompressed copy.
+ */
+static bool matchesTrailer(const std::string& compressed, const std::string& content)
+{
+    if (compressed.size() < 18) {
+        return false;
+    }
+
+    auto trailer = (const uint8_t*)compressed.data() + compressed.size() - 8;
+    uint32_t crc = trailer[0] | trailer[1] << 8 | trailer[2] << 16 | (uint32_t)trailer[3] << 24;
+    uint32_t size = trailer[4] | trailer[5] << 8 | trailer[6] << 16 | (uint32_t)trailer[7] << 24;
+    return crc == crc32((const uint8_t*)content.data(), content.size()) && size == (uint32_t)content.size();
+}
+
+/**
+ * Cuts the compressed data at up to 200 lengths before the trailer and counts how often that isn't noticed.
+ */
+static size_t countUndetectedCuts(const std::string& compressed)
+{
+    size_t undetected = 0;
+    size_t end = compressed.size() - 8;
+    size_t step = end / 200 + 1;
+    for (size_t cut = 0; cut < end; cut += step) {
+        bool failed;
+        inflateAll(compressed.substr(0, cut), failed);
+        undetected += !failed;
+    }
+
+    return undetected;
+}
+
+static size_t readEntries(Stream* stream, ICalEntry* entries, int32_t firstDay)
+{
+    size_t size = 0;
+    readICalStream(stream, entries, size, CALENDER_SIZE, firstDay);
+    return size;
+}
+
+static void benchFeed(const char* name, int32_t firstDay)
+{
+    auto compressed = loadFixture(name);
+    bool failed;
+    auto content = inflateAll(compressed, failed);
+    bool ok = !failed && matchesTrailer(compressed, content);
+
+    auto inflateNanos = measureNanos([&]() {
+        inflateAll(compressed, failed);
+    });
+
+    ICalEntry plain[CALENDER_SIZE], inflated[CALENDER_SIZE];
+    size_t plainSize = 0, inflatedSize = 0;
+    auto parseNanos = measureNanos([&]() {
+        MemoryStream stream(content);
+        plainSize = readEntries(&stream, plain, firstDay);
+    });
+    auto pipelineNanos = measureNanos([&]() {
+        MemoryStream source(compressed);
+        InflateStream* stream = new InflateStream(&source);
+        inflatedSize = readEntries(stream, inflated, firstDay);
+        delete stream;
+    });
+
+    bool same = plainSize == inflatedSize;
+    for (size_t i = 0; same && i < plainSize; ++i) {
+        same = plain[i].day == inflated[i].day && plain[i].summary == inflated[i].summary;
+    }
+
+    printf("%-20s %7zu B -> %7zu B %5.1fx   %-7s inflate %7.2f MB/s   parse %7.2f MB/s   inflate+parse %7.2f MB/s   entries %-6s %zu undetected cuts\n",
+        name, compressed.size(), content.size(), (double)content.size() / compressed.size(), ok ? "ok" : "DIFFERS",
+        content.size() / inflateNanos * 1e3, content.size() / parseNanos * 1e3, content.size() / pipelineNanos * 1e3,
+        same ? "same" : "DIFFER", countUndetectedCuts(compressed));
+}
+
+void benchInflate()
+{
+    setTimeZone(3600, 3600);
+    int32_t firstDay = daysFromCivil(2021, 1, 4);
+
+    printf("\ninflate (MB/s of uncompressed data, sizeof(InflateStream) %zu B)\n", sizeof(InflateStream));
+    benchFeed("small.ics.gz", firstDay);
+    benchFeed("awsh.ics.gz", firstDay);
+    benchFeed("pathological.ics.gz", firstDay);
+    benchFeed("recurring.ics.gz", firstDay);
+    benchFeed("synthetic.ics.gz", firstDay);
+}
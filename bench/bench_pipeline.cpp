@@ -0,0 +1,39 @@
+#include <chrono>
+#include <thread>
+
+#include "bench.h"
+#include "parallel.h"
+
+// the boot stages of the device with their typical durations, scaled down 1:10
+template <int MILLIS>
+static void simulate()
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(MILLIS));
+}
+
+void benchPipeline()
+{
+    PipelineStage stages[] = {
+        { "display", simulate<40>, 0 },
+        { "wifi", simulate<150>, 0 },
+        { "calender", simulate<80>, STAGE_BIT(1) },
+    };
+    const size_t count = sizeof(stages) / sizeof(stages[0]);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& stage : stages) {
+        stage.func();
+    }
+    std::chrono::duration<double> serial = std::chrono::steady_clock::now() - start;
+
+    runPipeline(stages, count);
+    uint32_t criticalPath = pipelineCriticalPath(stages, count);
+
+    uint32_t end = 0;
+    printf("\npipeline (simulated boot stages)\n");
+    for (size_t i = 0; i < count; ++i) {
+        end = stages[i].end > end ? stages[i].end : end;
+        printf("%-10s %6.1f - %6.1f ms%s\n", stages[i].name, stages[i].start / 1e3, stages[i].end / 1e3, criticalPath & STAGE_BIT(i) ? "   critical" : "");
+    }
+    printf("serial %6.1f ms   pipeline %6.1f ms\n", serial.count() * 1e3, end / 1e3);
+}
@@ -0,0 +1,130 @@
+#include <string.h>
+#include <string>
+
+#include "bench.h"
+#include "reconnect.h"
+
+/**
+ * An access point that can change its channel or go offline, with typical times of the esp32.
+ * Nothing is actually waited for, the time only moves forward on the clock of the radio.
+ */
+class FakeRadio : public WiFiRadio {
+public:
+    bool connect(const WiFiCache* cache, uint32_t timeoutMillis) override
+    {
+        usedIp = cache != nullptr ? cache->ip : 0;
+        bool found = online && (cache == nullptr || cache->channel == channel);
+        uint32_t millis = (cache != nullptr ? DIRECTED_MILLIS : SCAN_MILLIS) + (usedIp != 0 ? 0 : DHCP_MILLIS);
+        bool connected = found && millis <= timeoutMillis;
+        clock += connected ? millis : timeoutMillis;
+        return connected;
+    }
+
+    void remember(WiFiCache& cache) override
+    {
+        static const uint8_t BSSID[6] = { 0x24, 0x65, 0x11, 0x00, 0x00, 0x01 };
+        memcpy(cache.bssid, BSSID, sizeof(BSSID));
+        cache.channel = channel;
+        cache.ip = usedIp != 0 ? usedIp : 0x1400A8C0; // 192.168.0.20
+        cache.gateway = 0x0100A8C0;
+        cache.subnet = 0x00FFFFFF;
+        cache.dns = 0x0100A8C0;
+    }
+
+    void disconnect() override
+    {
+    }
+
+    uint32_t millis() override
+    {
+        return clock;
+    }
+
+    static const uint32_t SCAN_MILLIS = 2200;
+    static const uint32_t DIRECTED_MILLIS = 250;
+    static const uint32_t DHCP_MILLIS = 600;
+
+    uint8_t channel = 6;
+    bool online = true;
+    uint32_t clock = 0;
+    uint32_t usedIp = 0;
+};
+
+static std::string attemptsSince(const WiFiStats& stats, uint32_t since)
+{
+    std::string attempts;
+    for (uint32_t i = since; i < stats.attemptCount; ++i) {
+        auto& entry = stats.attempts[i % RECONNECT_STATS_SIZE];
+        attempts += attempts.empty() ? "" : " ";
+        attempts += entry.kind == ATTEMPT_CACHED ? "cached" : "scan";
+        attempts += entry.connected ? "+" : "-";
+    }
+
+    return attempts;
+}
+
+static size_t unexpected = 0;
+
+/**
+ * Runs one wake up and compares the attempts with the expected ones, + is a connection and - a failure.
+ */
+static void scenario(const char* name, FakeRadio& radio, WiFiCache& cache, WiFiStats& stats, time_t now, const char* expected, bool staticIp)
+{
+    uint32_t since = stats.attemptCount;
+    uint32_t start = radio.millis();
+    bool connected = reconnectWiFi(radio, cache, stats, now);
+    auto attempts = attemptsSince(stats, since);
+    bool ok = attempts == expected && (!connected || (radio.usedIp != 0) == staticIp) && cache.valid == connected && (!connected || cache.channel == radio.channel);
+    unexpected += !ok;
+
+    printf("%-26s %-16s %5u ms   %-9s %-7s %s\n", name, attempts.c_str(), radio.millis() - start, connected ? "connected" : "offline", radio.usedIp != 0 ? "static" : "dhcp", ok ? "ok" : "UNEXPECTED");
+}
+
+/**
+ * A year of daily wake ups, the access point moves to another channel every 60 days and is off for a day twice a year.
+ */
+static void simulateYear()
+{
+    FakeRadio radio;
+    WiFiCache cache = {};
+    WiFiStats stats = {};
+    time_t now = 1609459200;
+    uint32_t scanOnly = 0;
+    size_t offline = 0;
+    for (int day = 0; day < 365; ++day) {
+        radio.channel = 1 + (day / 60) * 5 % 13;
+        radio.online = day != 100 && day != 250;
+        offline += !reconnectWiFi(radio, cache, stats, now);
+        scanOnly += radio.online ? FakeRadio::SCAN_MILLIS + FakeRadio::DHCP_MILLIS : RECONNECT_SCAN_TIMEOUT;
+        now += 86400;
+    }
+
+    printf("a year of wake ups        scan every time %6.1f s   reconnect %6.1f s   %zu days offline\n", scanOnly / 1e3, radio.millis() / 1e3, offline);
+}
+
+void benchReconnect()
+{
+    FakeRadio radio;
+    WiFiCache cache = {};
+    WiFiStats stats = {};
+    time_t now = 1609459200;
+
+    printf("\nreconnect (fake radio)\n");
+    scenario("first boot", radio, cache, stats, now, "scan+", false);
+    scenario("next night", radio, cache, stats, now += 3600, "cached+", true);
+    scenario("lease ran out", radio, cache, stats, now += 2 * 86400, "cached+", false);
+    scenario("lease renewed", radio, cache, stats, now += 3600, "cached+", true);
+    radio.channel = 11;
+    scenario("access point moved", radio, cache, stats, now += 3600, "cached- scan+", false);
+    scenario("after the move", radio, cache, stats, now += 3600, "cached+", true);
+    radio.online = false;
+    scenario("access point off", radio, cache, stats, now += 3600, "cached- scan-", false);
+    scenario("still off", radio, cache, stats, now += 3600, "scan-", false);
+    radio.online = true;
+    scenario("back on", radio, cache, stats, now += 3600, "scan+", false);
+    scenario("clock lost", radio, cache, stats, 0, "cached+", false);
+    scenario("clock back", radio, cache, stats, now += 3600, "cached+", false);
+    printf("%zu unexpected\n", unexpected);
+
+    simulateYear();
+}
@@ -0,0 +1,318 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <time.h>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "canvas.h"
+#include "civil.h"
+#include "iCal.h"
+#include "profiler.h"
+#include "render.h"
+
+static const size_t CALENDER_SIZE = 32;
+
+/**
+ * The canvas of the device that also counts the drawPixel calls.
+ * Every call that is left is a pixel that didn't take a fast path.
+ */
+class CountingCanvas : public Canvas3C<400, 300> {
+public:
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        drawPixelCalls++;
+        Canvas3C::drawPixel(x, y, color);
+    }
+
+    unsigned long drawPixelCalls = 0;
+};
+
+static std::string toPPM(const CountingCanvas& canvas)
+{
+    char header[32];
+    snprintf(header, sizeof(header), "P6\n%d %d\n255\n", canvas.width(), canvas.height());
+
+    std::string image = header;
+    for (int16_t y = 0; y < canvas.height(); ++y) {
+        for (int16_t x = 0; x < canvas.width(); ++x) {
+            auto color = canvas.getPixel(x, y);
+            image += (char)(color == GxEPD_BLACK ? 0x00 : 0xFF);
+            image += (char)(color == GxEPD_WHITE ? 0xFF : 0x00);
+            image += (char)(color == GxEPD_WHITE ? 0xFF : 0x00);
+        }
+    }
+
+    return image;
+}
+
+static bool writeFile(const std::string& path, const std::string& content)
+{
+    auto file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+    return true;
+}
+
+/**
+ * Writes the rendering to render/ in the output directory to look at it.
+ * It isn't compared with golden images, those have to be rendered with the real fonts of Adafruit GFX first.
+ */
+static std::string writeRendering(const char* name, const CountingCanvas& canvas)
+{
+    auto path = outputPath("render/") + name + ".ppm";
+    if (!writeFile(path, toPPM(canvas))) {
+        return "not written";
+    }
+
+    return path;
+}
+
+template <typename F>
+static void benchScene(const char* name, F render)
+{
+    static CountingCanvas canvas;
+    canvas.setRotation(3);
+    canvas.fillScreen(GxEPD_WHITE);
+    canvas.drawPixelCalls = 0;
+    render(canvas);
+    auto calls = canvas.drawPixelCalls;
+    auto rendering = writeRendering(name, canvas);
+
+    auto nanos = measureNanos([&]() {
+        canvas.fillScreen(GxEPD_WHITE);
+        render(canvas);
+    });
+
+    printf("%-18s %8.1f us %8lu drawPixel   %s\n", name, nanos / 1e3, calls, rendering.c_str());
+}
+
+/**
+ * Reports what the layout pass decided, the width is narrowed to see the ellipsis with the summaries of the fixtures.
+ */
+static void benchLayout(const char* name, int16_t width, time_t timestamp, ICalEntry* entries, size_t size)
+{
+    static DisplayList list;
+    auto nanos = measureNanos([&]() {
+        layoutCalender(list, width, 300 - SMALL_LINE_HEIGHT, timestamp, entries, size);
+    });
+
+    size_t cut = 0;
+    const char* example = "";
+    for (size_t i = 0; i < list.count; ++i) {
+        auto length = strlen(list.items[i].text);
+        if (list.items[i].kind == ITEM_TEXT && length >= 3 && strcmp(list.items[i].text + length - 3, LAYOUT_ELLIPSIS) == 0) {
+            example = list.items[i].font == &LARGE_FONT && example[0] == '\0' ? list.items[i].text : example;
+            cut++;
+        }
+    }
+
+    printf("%-18s %8.1f us %4zu items   %2zu of %2zu entries fit%s   %zu cut %s\n", name, nanos / 1e3, list.count, list.fitCount, size, list.overflow ? " + fade" : "", cut, example);
+}
+
+/**
+ * Measures texts with a font of only 'A' to 'C' and compares them with the same texts without the characters
+ * Adafruit GFX skips, like the bytes of UTF-8 umlauts that are outside of 7 bit fonts.
+ */
+static void benchMetrics()
+{
+    static GFXglyph glyphs[] = {
+        { 0, 6, 8, 7, 0, -8 }, // A
+        { 0, 6, 8, 8, -1, -8 }, // B overhangs to the left
+        { 0, 9, 8, 7, 0, -8 }, // C reaches past its advance
+    };
+    static const GFXfont font = { nullptr, glyphs, 'A', 'C', 10 };
+    FontMetrics metrics(font);
+
+    struct {
+        const char* text;
+        const char* visible;
+    } cases[] = {
+        { "A\xC3\x84" "B", "AB" }, // A, Ä, B
+        { "\xC1", "" }, // 0xC1 is 'A' if only the low 7 bits are used
+        { "\xC3\x9C" "B", "B" },
+        { "C\xC3\x9F", "C" },
+        { "BAC\x7F ", "BAC" },
+    };
+
+    size_t differences = 0;
+    for (auto& c : cases) {
+        differences += metrics.advance(c.text, strlen(c.text)) != metrics.advance(c.visible, strlen(c.visible));
+        differences += metrics.width(c.text, strlen(c.text)) != metrics.width(c.visible, strlen(c.visible));
+        differences += metrics.left(c.text) != metrics.left(c.visible);
+    }
+    expect(differences == 0, "font metrics: %zu measures of skipped characters differ", differences);
+
+    printf("font metrics       %zu texts with skipped characters   %zu differences\n", sizeof(cases) / sizeof(cases[0]), differences);
+}
+
+/**
+ * Draws a frame page by page like main does with DISPLAY_PAGE_HEIGHT and compares the pages and band digests with the whole frame.
+ * A full refresh draws every page once for the digests and every page but the last one again to send it,
+ * so there is one SPI transaction per page. It is measured with and without the text cache.
+ */
+template <int16_t PAGE_HEIGHT, typename F>
+static void benchPages(const Canvas3C<400, 300>& whole, const uint32_t* expected, const DisplayList& list, F draw)
+{
+    typedef Canvas3C<400, 300, PAGE_HEIGHT> PageCanvas;
+    static PageCanvas canvas;
+    canvas.setRotation(whole.getRotation());
+    reserveTextCache(canvas, list);
+    auto frame = [&]() {
+        canvas.fillScreen(GxEPD_WHITE);
+        draw(canvas);
+    };
+
+    uint32_t digests[PageCanvas::MAX_BANDS];
+    canvas.digestPages(digests, frame);
+    size_t bands = 0, bytes = 0;
+    for (uint16_t band = 0; band < canvas.bandCount(); ++band) {
+        bands += digests[band] != expected[band];
+    }
+    for (uint16_t page = 0; page < PageCanvas::PAGE_COUNT; ++page) {
+        canvas.setPage(page);
+        frame();
+        size_t offset = canvas.getPageY() * PageCanvas::WIDTH_BYTES;
+        for (size_t i = 0; i < (size_t)canvas.getPageRows() * PageCanvas::WIDTH_BYTES; ++i) {
+            bytes += canvas.blackBuffer[i] != whole.blackBuffer[offset + i] || canvas.colorBuffer[i] != whole.colorBuffer[offset + i];
+        }
+    }
+
+    auto refreshNanos = [&]() {
+        return measureNanos([&]() {
+            canvas.digestPages(digests, frame);
+            for (uint16_t page = 0; page + 1 < PageCanvas::PAGE_COUNT; ++page) {
+                canvas.setPage(page);
+                frame();
+            }
+        });
+    };
+    auto digestNanos = measureNanos([&]() {
+        canvas.digestPages(digests, frame);
+    });
+    auto cachedNanos = refreshNanos();
+    size_t cacheSize = textCache.size();
+    textCache.release();
+    auto uncachedNanos = refreshNanos();
+
+    printf("page %3d rows %6zu bytes %3u pages %8.1f us digest %8.1f us full refresh %8.1f us with %5zu bytes text cache   %zu different bands %zu different bytes\n",
+        PAGE_HEIGHT, sizeof(canvas.blackBuffer) + sizeof(canvas.colorBuffer), PageCanvas::PAGE_COUNT,
+        digestNanos / 1e3, uncachedNanos / 1e3, cachedNanos / 1e3, cacheSize, bands, bytes);
+    expect(bands == 0 && bytes == 0, "%d rows per page differ from the whole frame", PAGE_HEIGHT);
+}
+
+static size_t readFixture(const char* name, ICalEntry* entries, int32_t firstDay)
+{
+    auto content = loadFixture(name);
+    MemoryStream stream(content);
+    size_t size = 0;
+    readICalStream(&stream, entries, size, CALENDER_SIZE, firstDay);
+    return size;
+}
+
+/**
+ * Compares frames like updateDisplay does with DISPLAY_IGNORE_FOOTER, only the bands above calenderBottom.
+ * A frame that only differs in the footer has to count as unchanged, one that differs in the last row of the calender not.
+ */
+static void benchFooterBands(time_t timestamp, ICalEntry* entries, size_t size)
+{
+    typedef Canvas3C<400, 300> Frame;
+    static Frame canvas;
+    static DisplayList list;
+    canvas.setRotation(3);
+    int16_t bottom = calenderBottom(canvas.height(), Frame::BAND_HEIGHT);
+    uint16_t compared = bottom / Frame::BAND_HEIGHT;
+    layoutCalender(list, canvas.width(), bottom, timestamp, entries, size);
+
+    auto digestFrame = [&](uint32_t* digests, unsigned sleepTime, bool lastRow) {
+        canvas.digestPages(digests, [&]() {
+            canvas.fillScreen(GxEPD_WHITE);
+            drawDisplayList(canvas, list);
+            if (lastRow) {
+                canvas.drawFastHLine(0, bottom - 1, canvas.width(), GxEPD_BLACK);
+            }
+            renderFooter(canvas, timestamp, sleepTime, 3150);
+        });
+    };
+
+    uint32_t displayed[Frame::MAX_BANDS], footer[Frame::MAX_BANDS], lastRow[Frame::MAX_BANDS];
+    digestFrame(displayed, 3600, false);
+    digestFrame(footer, 7200, false);
+    digestFrame(lastRow, 3600, true);
+    bool footerIgnored = memcmp(displayed, footer, compared * sizeof(uint32_t)) == 0;
+    bool lastRowSeen = memcmp(displayed, lastRow, compared * sizeof(uint32_t)) != 0;
+    expect(footerIgnored, "footer bands: a frame that only differs in the footer would be refreshed");
+    expect(lastRowSeen, "footer bands: a change in row %d, the last one of the calender, would be missed", bottom - 1);
+
+    printf("\nfooter bands       calender ends at row %d, %u of %u bands compared   footer %s   last row %s\n", bottom, compared,
+        canvas.bandCount(), footerIgnored ? "ignored" : "REFRESHED", lastRowSeen ? "refreshed" : "MISSED");
+}
+
+void benchRender()
+{
+    // the dates are rendered in the timezone of the device
+    setTimeZone(3600, 3600);
+
+    time_t timestamp = fromLocalTime(2021, 1, 4, 6 * 3600);
+
+    static ICalEntry small[CALENDER_SIZE], awsh[CALENDER_SIZE];
+    size_t smallSize = readFixture("small.ics", small, localDays(timestamp));
+    size_t awshSize = readFixture("awsh.ics", awsh, localDays(timestamp));
+
+    printf("\nrender\n");
+    benchScene("calender-small", [&](CountingCanvas& canvas) {
+        renderCalender(canvas, timestamp, small, smallSize);
+    });
+    benchScene("calender-awsh", [&](CountingCanvas& canvas) {
+        renderCalender(canvas, timestamp, awsh, awshSize);
+    });
+    benchScene("calender-empty", [&](CountingCanvas& canvas) {
+        renderCalender(canvas, timestamp, awsh, 0);
+    });
+    benchLayout("layout small", 300, timestamp, small, smallSize);
+    benchLayout("layout awsh", 300, timestamp, awsh, awshSize);
+    benchLayout("layout awsh narrow", 120, timestamp, awsh, awshSize);
+    benchMetrics();
+    benchScene("footer", [&](CountingCanvas& canvas) {
+        renderFooter(canvas, timestamp, 3 * 3600 + 25 * 60, 3150);
+    });
+    static ProfileLog profile;
+    for (uint32_t awake : { 4200, 3900, 6100, 4000, 12800, 4100 }) {
+        beginProfileCycle(profile);
+        profile.cycles[(profile.cycleCount - 1) % PROFILE_CYCLES].start[PHASE_SLEEP] = awake;
+    }
+    benchScene("footer-profile", [&](CountingCanvas& canvas) {
+        renderFooter(canvas, timestamp, 3 * 3600 + 25 * 60, 3150, 74, &profile);
+    });
+    benchScene("error", [&](CountingCanvas& canvas) {
+        renderError(canvas, "Fehler", "calender download failed with http status 404");
+    });
+
+    // the frame of the device, the layout is done once and every page draws the display list
+    printf("\npaged render (calender-awsh with footer)\n");
+    static DisplayList list;
+    layoutCalender(list, 300, 400 - SMALL_LINE_HEIGHT, timestamp, awsh, awshSize);
+    auto frame = [&](auto& canvas) {
+        drawDisplayList(canvas, list);
+        renderFooter(canvas, timestamp, 3 * 3600 + 25 * 60, 3150, 74);
+    };
+    static Canvas3C<400, 300> whole;
+    whole.setRotation(3);
+    uint32_t digests[Canvas3C<400, 300>::MAX_BANDS];
+    whole.digestPages(digests, [&]() {
+        whole.fillScreen(GxEPD_WHITE);
+        frame(whole);
+    });
+    benchPages<300>(whole, digests, list, frame);
+    benchPages<150>(whole, digests, list, frame);
+    benchPages<100>(whole, digests, list, frame);
+    benchPages<60>(whole, digests, list, frame);
+    benchPages<30>(whole, digests, list, frame);
+    benchPages<10>(whole, digests, list, frame);
+
+    benchFooterBands(timestamp, awsh, awshSize);
+}
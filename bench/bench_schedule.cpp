@@ -0,0 +1,98 @@
+#include <string>
+#include <vector>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+#include "schedule.h"
+
+static const size_t CALENDER_SIZE = 32;
+
+// the entries that fit on the screen, changes further down the list can't be seen
+static const size_t VISIBLE_ENTRIES = 8;
+
+static const SleepPolicy POLICY = { 7, 3400, 30 };
+
+/**
+ * Reads the feed like a download on the given day does.
+ */
+static std::vector<ICalEntry> readFeed(const std::string& content, int32_t day)
+{
+    std::vector<ICalEntry> entries(CALENDER_SIZE);
+    size_t size = 0;
+    MemoryStream stream(content);
+    readICalStream(&stream, entries.data(), size, CALENDER_SIZE, day);
+    entries.resize(size);
+    return entries;
+}
+
+/**
+ * What renderCalender shows on the given day: the visible entries that aren't over yet and their headers.
+ */
+static std::vector<int32_t> renderedOn(const std::vector<ICalEntry>& entries, int32_t day)
+{
+    std::vector<int32_t> rendered;
+    for (auto& entry : entries) {
+        if (entry.day < day) {
+            continue;
+        }
+        if (rendered.size() / 3 == VISIBLE_ENTRIES) {
+            break;
+        }
+
+        int32_t offset = entry.day - day;
+        rendered.push_back(entry.day);
+        rendered.push_back(entry.summary);
+        rendered.push_back(offset <= 1 ? offset : offset <= SCHEDULE_WEEKDAY_DAYS ? 2 : 3);
+    }
+
+    return rendered;
+}
+
+/**
+ * Replays a year of nights and counts the wake ups and the days on which the screen showed something outdated.
+ * A policy of nullptr is the old behaviour of waking up every night.
+ */
+static void simulate(const char* name, const std::string& content, const SleepPolicy* policy, uint32_t millivolt)
+{
+    int32_t firstDay = daysFromCivil(2021, 1, 1);
+    int32_t endDay = daysFromCivil(2022, 1, 1);
+
+    // what a download on each day would return
+    std::vector<std::vector<ICalEntry>> feeds;
+    for (int32_t day = firstDay; day < endDay; ++day) {
+        feeds.push_back(readFeed(content, day));
+    }
+
+    size_t wakes = 0, staleDays = 0;
+    int32_t longest = 0;
+    int32_t day = firstDay;
+    while (day < endDay) {
+        auto& entries = feeds[day - firstDay];
+        auto shown = renderedOn(entries, day);
+        wakes++;
+
+        int32_t next = policy != nullptr ? nextWakeDay(entries.data(), entries.size(), day, millivolt, -1, *policy) : day + 1;
+        longest = next - day > longest ? next - day : longest;
+        for (int32_t later = day + 1; later < next && later < endDay; ++later) {
+            staleDays += renderedOn(feeds[later - firstDay], later) != shown;
+        }
+        day = next;
+    }
+
+    printf("%-14s %-22s %4zu wakes   longest sleep %3d days   %3zu days outdated\n", name, policy == nullptr ? "every night" : millivolt < policy->lowMillivolt ? "adaptive, low voltage" : "adaptive", wakes, (int)longest, staleDays);
+}
+
+void benchSchedule()
+{
+    setTimeZone(3600, 3600);
+
+    printf("\nschedule (a year of nights, wake up at least every %d days)\n", (int)POLICY.maxDays);
+    for (auto name : { "small.ics", "awsh.ics", "recurring.ics" }) {
+        auto content = loadFixture(name);
+        simulate(name, content, nullptr, 0);
+        simulate(name, content, &POLICY, 3900);
+        simulate(name, content, &POLICY, 3300);
+    }
+}
@@ -0,0 +1,100 @@
+#include <string.h>
+#include <string>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+#include "snapshot.h"
+
+static const size_t CALENDER_SIZE = 32;
+static const size_t SNAPSHOT_SIZE = 512;
+
+static bool sameEntries(const ICalEntry* a, size_t aSize, const ICalEntry* b, size_t bSize)
+{
+    if (aSize != bSize) {
+        return false;
+    }
+
+    for (size_t i = 0; i < aSize; ++i) {
+        if (a[i].day != b[i].day || a[i].source != b[i].source || strcmp(icalSummary(a[i].summary), icalSummary(b[i].summary)) != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Damages the snapshot in every way that is cheap to try and counts how often it is still accepted.
+ * Every bit is flipped once and the snapshot is cut at every length.
+ */
+static size_t countAcceptedCorruptions(const uint8_t* snapshot, size_t length)
+{
+    size_t accepted = 0;
+    uint8_t damaged[SNAPSHOT_SIZE];
+    ICalEntry entries[CALENDER_SIZE];
+    size_t count;
+
+    for (size_t bit = 0; bit < length * 8; ++bit) {
+        memcpy(damaged, snapshot, length);
+        damaged[bit / 8] ^= 1 << (bit % 8);
+        accepted += readSnapshot(damaged, length, entries, count, CALENDER_SIZE);
+    }
+
+    for (size_t cut = 0; cut < length; ++cut) {
+        accepted += readSnapshot(snapshot, cut, entries, count, CALENDER_SIZE);
+    }
+
+    memcpy(damaged, snapshot, length);
+    damaged[0] = SNAPSHOT_VERSION + 1;
+    accepted += readSnapshot(damaged, length, entries, count, CALENDER_SIZE);
+
+    return accepted;
+}
+
+static void benchFeed(const char* name, const std::string& content, int32_t firstDay, uint8_t source)
+{
+    ICalEntry entries[CALENDER_SIZE];
+    size_t size = 0;
+    MemoryStream stream(content);
+    readICalStream(&stream, entries, size, CALENDER_SIZE, firstDay, source);
+
+    uint8_t snapshot[SNAPSHOT_SIZE];
+    size_t length = writeSnapshot(snapshot, sizeof(snapshot), entries, size, SNAPSHOT_COMPLETE);
+
+    ICalEntry restored[CALENDER_SIZE];
+    size_t restoredSize = 0;
+    uint8_t flags = 0;
+    bool read = readSnapshot(snapshot, length, restored, restoredSize, CALENDER_SIZE, &flags);
+    bool same = read && flags == SNAPSHOT_COMPLETE && sameEntries(entries, size, restored, restoredSize);
+
+    // a list that is larger than the reader allows must be rejected instead of overflowing it
+    bool limited = size == 0 || !readSnapshot(snapshot, length, restored, restoredSize, size - 1);
+
+    auto writeNanos = measureNanos([&]() { writeSnapshot(snapshot, sizeof(snapshot), entries, size); }, 0.1);
+    writeSnapshot(snapshot, sizeof(snapshot), entries, size, SNAPSHOT_COMPLETE);
+    auto readNanos = measureNanos([&]() { readSnapshot(snapshot, length, restored, restoredSize, CALENDER_SIZE); }, 0.1);
+
+    printf("%-10s %3zu entries %5zu B raw %4zu B snapshot   write %6.2f us   read %6.2f us   %s   %zu corruptions accepted\n",
+        name,
+        size,
+        size * sizeof(ICalEntry),
+        length,
+        writeNanos / 1e3,
+        readNanos / 1e3,
+        same && limited ? "roundtrip ok" : "ROUNDTRIP FAILED",
+        countAcceptedCorruptions(snapshot, length));
+}
+
+void benchSnapshot()
+{
+    setTimeZone(3600, 3600);
+    int32_t firstDay = daysFromCivil(2021, 1, 4);
+
+    printf("\nsnapshot\n");
+    benchFeed("small", loadFixture("small.ics"), firstDay, 0);
+    benchFeed("awsh", loadFixture("awsh.ics"), firstDay, 1);
+    benchFeed("recurring", loadFixture("recurring.ics"), firstDay, 2);
+    benchFeed("empty", "", firstDay, 0);
+}
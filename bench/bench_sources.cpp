@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+#include "parallel.h"
+
+static const size_t CALENDER_SIZE = 32;
+static const size_t SOURCE_COUNT = 3;
+
+/**
+ * A MemoryStream that waits before every read like a slow connection does.
+ */
+class SlowStream : public MemoryStream {
+public:
+    using MemoryStream::MemoryStream;
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        return MemoryStream::readBytes(buffer, std::min(length, (size_t)1024));
+    }
+};
+
+struct Source {
+    const std::string* content;
+    ICalEntry entries[CALENDER_SIZE];
+    size_t entryCount;
+    ICalResult result;
+};
+
+static Source sources[SOURCE_COUNT];
+static int32_t firstDay;
+
+static void readSource(size_t index, void* context)
+{
+    auto& source = sources[index];
+    SlowStream stream(*source.content);
+    source.entryCount = 0;
+    source.result = readICalStream(&stream, source.entries, source.entryCount, CALENDER_SIZE, firstDay, index);
+}
+
+static double measureMillis(void (*func)())
+{
+    auto start = std::chrono::steady_clock::now();
+    func();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() * 1e3;
+}
+
+/**
+ * Merges the sources like updateCalender does and compares it with sorting all entries at once.
+ */
+static size_t countMergeDifferences()
+{
+    const ICalEntry* lists[SOURCE_COUNT];
+    size_t listSizes[SOURCE_COUNT];
+    std::vector<ICalEntry> expected;
+    for (size_t i = 0; i < SOURCE_COUNT; ++i) {
+        lists[i] = sources[i].entries;
+        listSizes[i] = sources[i].entryCount;
+        expected.insert(expected.end(), sources[i].entries, sources[i].entries + sources[i].entryCount);
+    }
+
+    std::stable_sort(expected.begin(), expected.end(), [](const ICalEntry& a, const ICalEntry& b) { return a.day < b.day; });
+    expected.resize(std::min(expected.size(), CALENDER_SIZE));
+
+    ICalEntry merged[CALENDER_SIZE];
+    size_t mergedSize = mergeICalEntries(lists, listSizes, SOURCE_COUNT, merged, CALENDER_SIZE);
+
+    size_t differences = expected.size() > mergedSize ? expected.size() - mergedSize : mergedSize - expected.size();
+    for (size_t i = 0; i < std::min(expected.size(), mergedSize); ++i) {
+        differences += merged[i].day != expected[i].day || merged[i].source != expected[i].source || merged[i].summary != expected[i].summary;
+    }
+
+    return differences;
+}
+
+void benchSources()
+{
+    setTimeZone(3600, 3600);
+    firstDay = daysFromCivil(2021, 1, 4);
+
+    static const std::string contents[SOURCE_COUNT] = {
+        loadFixture("awsh.ics"),
+        loadFixture("awsh.ics"),
+        loadFixture("recurring.ics"),
+    };
+    for (size_t i = 0; i < SOURCE_COUNT; ++i) {
+        sources[i].content = &contents[i];
+    }
+
+    printf("\nsources (%zu calenders, 2 ms per read)\n", SOURCE_COUNT);
+    auto serial = measureMillis([]() {
+        for (size_t i = 0; i < SOURCE_COUNT; ++i) {
+            readSource(i, nullptr);
+        }
+    });
+    auto concurrent = measureMillis([]() {
+        runConcurrently(SOURCE_COUNT, readSource, nullptr);
+    });
+
+    size_t failed = 0;
+    for (auto& source : sources) {
+        failed += source.result != ICAL_END;
+    }
+
+    printf("serial %8.1f ms   concurrent %8.1f ms   %zu failed   %zu merge differences\n", serial, concurrent, failed, countMergeDifferences());
+}
@@ -0,0 +1,85 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "civil.h"
+#include "timeSource.h"
+
+struct DateCase {
+    const char* text;
+    time_t expected;
+};
+
+static const DateCase DATE_CASES[] = {
+    { "Sun, 06 Nov 1994 08:49:37 GMT", 784111777 },
+    { "Mon, 04 Jan 2021 06:00:00 GMT", 1609740000 },
+    { "Thu, 29 Feb 2024 23:59:59 GMT", 1709251199 },
+    { "Fri, 31 Dec 2049 12:30:00 GMT", 2524566600 },
+    { "Sunday, 06-Nov-94 08:49:37 GMT", 0 }, // RFC 850, obsolete
+    { "Sun Nov  6 08:49:37 1994", 0 }, // asctime, obsolete
+    { "Sun, 06 Nov 1994 08:49:37 UTC", 0 },
+    { "Sun, 06 Foo 1994 08:49:37 GMT", 0 },
+    { "Sun, 6 Nov 1994 08:49:37 GMT", 0 },
+    { "", 0 },
+};
+
+/**
+ * A year of nights on an RTC that runs fast by drift ppm, plus some noise from the temperature.
+ * The clock is set to the server time on every download, every downloadDays days.
+ * Without the model the device trusts the clock, with it the clock is corrected and the sleep time stretched.
+ * A wake up on the wrong day is one where the device believes it is a different local day than it actually is.
+ */
+static void simulate(int32_t drift, int32_t downloadDays, bool model)
+{
+    ClockHistory history = {};
+    time_t real = fromLocalTime(2021, 1, 1, 2 * 3600);
+    double clock = real;
+    uint32_t seed = 1;
+    double maxError = 0;
+    size_t wrongDays = 0, wakes = 0;
+
+    for (int32_t night = 0; night < 365; ++night) {
+        wakes++;
+        if (night % downloadDays == 0) {
+            syncClock(history, real, night == 0 ? 0 : (time_t)clock);
+            clock = real;
+        }
+
+        time_t believed = model ? correctClock(history, (time_t)clock) : (time_t)clock;
+        double error = fabs((double)believed - real);
+        wrongDays += localDays(believed) != localDays(real);
+        // until the second download nothing is known about the drift
+        if (history.driftCount > 0) {
+            maxError = error > maxError ? error : maxError;
+        }
+
+        // sleep until 02:00 of the next day as the device believes it
+        uint32_t seconds = fromLocalDays(localDays(believed) + 1, 2 * 3600) - believed;
+        uint32_t sleep = model ? clockSeconds(history, seconds) : seconds;
+        seed = seed * 1103515245 + 12345;
+        double actualDrift = drift + (int32_t)(seed >> 16) % 2001 - 1000;
+        clock += sleep;
+        real += (time_t)(sleep / (1 + actualDrift / 1e6));
+    }
+
+    printf("%6d ppm   download every %d days   %-8s %3zu wakes   max error once learned %6.1f min   %3zu wakes on the wrong day\n",
+        (int)drift, (int)downloadDays, model ? "model" : "no model", wakes, maxError / 60, wrongDays);
+}
+
+void benchTimeSource()
+{
+    setTimeZone(3600, 3600);
+
+    size_t wrong = 0;
+    for (auto& c : DATE_CASES) {
+        wrong += parseHttpDate(c.text) != c.expected;
+    }
+    printf("\ntime source\n%zu of %zu http dates parsed wrong\n", wrong, sizeof(DATE_CASES) / sizeof(DATE_CASES[0]));
+
+    for (int32_t drift : { 5000, 20000, -20000 }) {
+        for (int32_t days : { 2, 7 }) {
+            simulate(drift, days, false);
+            simulate(drift, days, true);
+        }
+    }
+}
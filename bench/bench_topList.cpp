@@ -0,0 +1,182 @@
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <vector>
+
+#include "MemoryStream.h"
+#include "bench.h"
+#include "civil.h"
+#include "iCal.h"
+#include "inflate.h"
+#include "topList.h"
+
+// the insertion that was used before TopList, kept as reference
+template <typename T>
+size_t addToSortedList(T* list, size_t& listSize, const size_t& maxListSize, const T& item, bool (*isGreaterThan)(const T&, const T&))
+{
+    for (size_t i = 0; i < listSize; ++i) {
+        if (!isGreaterThan(list[i], item)) {
+            continue;
+        }
+
+        if (listSize < maxListSize) {
+            listSize++;
+        }
+
+        size_t itemsToMove = listSize - i - 1;
+        memmove(&list[i + 1], &list[i], itemsToMove * sizeof(T));
+        memcpy(&list[i], &item, sizeof(T));
+        return i;
+    }
+
+    if (listSize < maxListSize) {
+        memcpy(&list[listSize], &item, sizeof(T));
+        return listSize++;
+    }
+
+    return maxListSize;
+};
+
+static bool isLater(const ICalEntry& a, const ICalEntry& b)
+{
+    return a.day > b.day;
+}
+
+static bool sameEntries(const std::vector<ICalEntry>& a, size_t aSize, const std::vector<ICalEntry>& b, size_t bSize)
+{
+    if (aSize != bSize) {
+        return false;
+    }
+
+    for (size_t i = 0; i < aSize; ++i) {
+        if (a[i].day != b[i].day || a[i].summary != b[i].summary || a[i].source != b[i].source) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void benchOrder(const char* order, const std::vector<ICalEntry>& input)
+{
+    for (size_t capacity : { 8, 64, 256 }) {
+        std::vector<ICalEntry> list(capacity), heap(capacity);
+        std::vector<uint32_t> insertions(capacity);
+        size_t listSize = 0, heapSize = 0;
+
+        auto sortedNanos = measureNanos([&]() {
+            listSize = 0;
+            for (auto& entry : input) {
+                addToSortedList<ICalEntry>(list.data(), listSize, capacity, entry, isLater);
+            }
+        });
+
+        auto heapNanos = measureNanos([&]() {
+            TopList<ICalEntry, isLater> top(heap.data(), insertions.data(), capacity);
+            for (auto& entry : input) {
+                top.add(entry);
+            }
+            heapSize = top.size();
+            top.sort();
+        });
+
+        expect(sameEntries(list, listSize, heap, heapSize), "%s: TopList with %zu items differs from addToSortedList", order, capacity);
+
+        printf("%-10s %6zu items K=%-4zu addToSortedList %8.1f ns/item   TopList %8.1f ns/item\n",
+            order, input.size(), capacity, sortedNanos / input.size(), heapNanos / input.size());
+    }
+}
+
+// recurring entries without an end are only expanded this far
+static const int32_t HORIZON_DAYS = 100 * 365;
+
+/**
+ * Every occurrence of the feed in the order readICalStream gets them.
+ */
+static std::vector<ICalEntry> feedOccurrences(const std::string& content, int32_t firstDay)
+{
+    std::vector<ICalEntry> occurrences;
+    ICalParser parser;
+    size_t offset = 0;
+    ICalResult result;
+    do {
+        size_t consumed = 0;
+        result = offset < content.size() ? parser.write(content.data() + offset, content.size() - offset, consumed) : parser.finish();
+        offset += consumed;
+        if (result == ICAL_OK) {
+            ICalEntry entry = parser.entry();
+            entry.summary = parser.internSummary();
+            entry.source = 0;
+            ICalOccurrences next(parser.recurrence(), firstDay);
+            while (next.next(entry.day) && entry.day < firstDay + HORIZON_DAYS) {
+                occurrences.push_back(entry);
+            }
+        }
+    } while (result == ICAL_OK || (result == ICAL_NEED_MORE && offset < content.size()));
+
+    return occurrences;
+}
+
+/**
+ * Feeds the occurrences of a fixture into addToSortedList, TopList and readICalStream,
+ * all of them have to keep the same entries in the same order, also the ones on the same day.
+ */
+static void compareWithLegacy(const char* name, const std::string& content, int32_t firstDay)
+{
+    auto input = feedOccurrences(content, firstDay);
+    bool same = true;
+    for (size_t capacity : { 8, 32, 256 }) {
+        std::vector<ICalEntry> legacy(capacity), top(capacity), read(capacity);
+        std::vector<uint32_t> order(capacity);
+        size_t legacySize = 0, readSize = 0;
+        TopList<ICalEntry, isLater> list(top.data(), order.data(), capacity);
+        for (auto& entry : input) {
+            addToSortedList<ICalEntry>(legacy.data(), legacySize, capacity, entry, isLater);
+            list.add(entry);
+        }
+        list.sort();
+        same &= expect(sameEntries(legacy, legacySize, top, list.size()), "%s: TopList with %zu items differs from addToSortedList", name, capacity);
+
+        // readICalStream expands everything, so it can only be compared if the horizon didn't cut the list
+        MemoryStream stream(content);
+        readICalStream(&stream, read.data(), readSize, capacity, firstDay);
+        if (legacySize < capacity || legacy[legacySize - 1].day < firstDay + HORIZON_DAYS - 1) {
+            same &= expect(sameEntries(legacy, legacySize, read, readSize), "%s: readICalStream with %zu items differs from addToSortedList", name, capacity);
+        }
+    }
+
+    printf("%-20s %6zu occurrences   %s\n", name, input.size(), same ? "same as addToSortedList" : "DIFFERS");
+}
+
+void benchTopList()
+{
+    int32_t firstDay = daysFromCivil(2021, 1, 4);
+    printf("\ntop list (fixtures)\n");
+    for (auto name : { "small.ics", "awsh.ics", "recurring.ics", "pathological.ics", "alarm.ics", "ordinals.ics", "ties.ics" }) {
+        compareWithLegacy(name, loadFixture(name), firstDay);
+    }
+    auto compressed = loadFixture("synthetic.ics.gz");
+    MemoryStream source(compressed);
+    std::unique_ptr<InflateStream> inflate(new InflateStream(&source));
+    std::string synthetic;
+    char buffer[256];
+    while (auto length = inflate->readBytes(buffer, sizeof(buffer))) {
+        synthetic.append(buffer, length);
+    }
+    compareWithLegacy("synthetic.ics.gz", synthetic, firstDay);
+
+    std::vector<ICalEntry> input(10000);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i].day = 18628 + i / 2; // two entries a day, like most feeds
+        input[i].summary = i % 4;
+    }
+
+    printf("\ntop list\n");
+    benchOrder("ascending", input); // feeds are usually sorted
+
+    srand(1);
+    for (size_t i = input.size() - 1; i > 0; --i) {
+        std::swap(input[i], input[rand() % (i + 1)]);
+    }
+    benchOrder("shuffled", input);
+}
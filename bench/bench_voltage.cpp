@@ -0,0 +1,67 @@
+#include <stdlib.h>
+
+#include "bench.h"
+#include "voltage.h"
+
+static const uint32_t EMPTY_MILLIVOLT = 3000;
+static const int32_t BATTERY_DAYS = 240;
+
+/**
+ * A battery that loses the same voltage every day, read through an ADC with noise and the occasional spike.
+ */
+struct SimulatedBattery {
+    double millivolt;
+    uint32_t seed;
+
+    int32_t noise(int32_t range)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (int32_t)(seed >> 16) % (2 * range + 1) - range;
+    }
+};
+
+static uint32_t readSimulated(void* context)
+{
+    auto battery = (SimulatedBattery*)context;
+    int32_t noise = battery->noise(40);
+    if (battery->noise(50) == 0) {
+        noise += 400; // a spike
+    }
+    return battery->millivolt + noise;
+}
+
+static double absolute(double value)
+{
+    return value < 0 ? -value : value;
+}
+
+void benchVoltage()
+{
+    SimulatedBattery battery = { 4150, 1 };
+    double slope = (battery.millivolt - EMPTY_MILLIVOLT) / BATTERY_DAYS;
+    VoltageHistory history = {};
+    time_t now = 1609459200;
+    double singleError = 0, burstError = 0, averageError = 0;
+
+    printf("\nvoltage (a battery that is empty after %d days, one wake up per day)\n", (int)BATTERY_DAYS);
+    for (int32_t day = 0; day < BATTERY_DAYS; ++day) {
+        uint32_t single = readSimulated(&battery);
+        uint32_t burst = sampleVoltage(readSimulated, &battery);
+        uint32_t average = updateVoltage(history, burst, now);
+        int32_t daysLeft = voltageDaysLeft(history, EMPTY_MILLIVOLT);
+
+        singleError += absolute(single - battery.millivolt);
+        burstError += absolute(burst - battery.millivolt);
+        averageError += absolute(average - battery.millivolt);
+        if (day % 30 == 0 || day == BATTERY_DAYS - 1) {
+            printf("day %3d   %7.1f mV   single %4u mV   burst %4u mV   average %4u mV   %4d days left, actually %3d\n",
+                (int)day, battery.millivolt, single, burst, average, (int)daysLeft, (int)(BATTERY_DAYS - day));
+        }
+
+        battery.millivolt -= slope;
+        now += 86400 + battery.noise(1800); // the wake up time drifts a bit
+    }
+
+    printf("mean error   single %5.1f mV   burst %5.1f mV   average %5.1f mV\n",
+        singleError / BATTERY_DAYS, burstError / BATTERY_DAYS, averageError / BATTERY_DAYS);
+}
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Decodes the binary log that dumpLog writes when LOG_BINARY is set.
+
+The log only contains pointers to the format strings, the tags and string arguments,
+so they are looked up in the firmware the device runs.
+
+    python3 bench/decode_log.py .pio/build/wemos_d1_mini32/firmware.elf serial-capture.bin
+"""
+
+import re
+import struct
+import sys
+
+MAGIC = b"LOGB"
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+def read_sections(path):
+    """Returns (address, content) of every section that is loaded on the device."""
+    with open(path, "rb") as file:
+        elf = file.read()
+
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        sys.exit("%s is not a 32 bit elf file" % path)
+
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", elf, 0x2E)
+    sections = []
+    for i in range(shnum):
+        _, type, flags, address, offset, size = struct.unpack_from("<IIIIII", elf, shoff + i * shentsize)
+        if flags & SHF_ALLOC and type != SHT_NOBITS and size > 0:
+            sections.append((address, elf[offset:offset + size]))
+
+    return sections
+
+
+def read_string(sections, pointer):
+    for address, content in sections:
+        if address <= pointer < address + len(content):
+            end = content.find(b"\0", pointer - address)
+            return content[pointer - address:end].decode("latin-1")
+
+    # strings on the stack or heap are gone
+    return "<0x%08x>" % pointer
+
+
+CONVERSION = re.compile(r"%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diuxXoscp%])")
+
+
+def format_record(sections, format, args):
+    args = list(args)
+
+    def replace(match):
+        flags, conversion = match.groups()
+        if conversion == "%":
+            return "%"
+
+        arg = args.pop(0) if args else 0
+        if conversion in "di":
+            return ("%" + flags + "d") % (arg - (1 << 32) if arg & (1 << 31) else arg)
+        if conversion == "s":
+            return ("%" + flags + "s") % read_string(sections, arg)
+        if conversion == "p":
+            return "0x%08x" % arg
+        if conversion == "u":
+            return ("%" + flags + "d") % arg
+        return ("%" + flags + conversion) % arg
+
+    return CONVERSION.sub(replace, format)
+
+
+def decode(sections, dump):
+    position = dump.find(MAGIC)
+    if position < 0:
+        sys.exit("no binary log found")
+
+    position += len(MAGIC)
+    while position + 8 <= len(dump):
+        time, header = struct.unpack_from("<II", dump, position)
+        level, count = header & 0xFF, header >> 8 & 0xFF
+        if level == 0:
+            if time > 0:
+                print("%u log records lost" % time)
+            return
+
+        tag, format = struct.unpack_from("<II", dump, position + 8)
+        args = struct.unpack_from("<%dI" % count, dump, position + 16)
+        position += 16 + 4 * count
+        message = format_record(sections, read_string(sections, format), args)
+        print("%c (%u) %s: %s" % (level, time, read_string(sections, tag), message))
+
+    print("the binary log ended unexpected")
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+
+    with open(sys.argv[2], "rb") as file:
+        decode(read_sections(sys.argv[1]), file.read())
@@ -0,0 +1,93 @@
+#include <filesystem>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "bench.h"
+
+// run with `pio run -e native -t exec` from the project directory
+// or pass the fixture directory as the first argument and the output directory as the second one
+static std::string fixtureDirectory = "bench/fixtures";
+static std::string outputDirectory = ".pio/bench";
+static size_t failures = 0;
+
+bool expect(bool condition, const char* format, ...)
+{
+    if (!condition) {
+        va_list args;
+        va_start(args, format);
+        printf("FAILED: ");
+        vprintf(format, args);
+        printf("\n");
+        va_end(args);
+        failures++;
+    }
+
+    return condition;
+}
+
+std::string fixturePath(const char* name)
+{
+    return fixtureDirectory + "/" + name;
+}
+
+std::string outputPath(const char* name)
+{
+    auto path = outputDirectory + "/" + name;
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    return path;
+}
+
+std::string loadFixture(const char* name)
+{
+    auto path = fixturePath(name);
+    auto file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        fprintf(stderr, "fixture %s not found\n", path.c_str());
+        exit(1);
+    }
+
+    std::string content;
+    char buffer[4096];
+    while (auto length = fread(buffer, 1, sizeof(buffer), file)) {
+        content.append(buffer, length);
+    }
+
+    fclose(file);
+    return content;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        fixtureDirectory = argv[1];
+    }
+    if (argc > 2) {
+        outputDirectory = argv[2];
+    }
+
+    benchICal();
+    benchTopList();
+    benchCivil();
+    benchDither();
+    benchCanvas();
+    benchRender();
+    benchSources();
+    benchPipeline();
+    benchSnapshot();
+    benchInflate();
+    benchSchedule();
+    benchVoltage();
+    benchReconnect();
+    benchTimeSource();
+    benchConditionalGet();
+
+    if (failures > 0) {
+        printf("\n%zu expectations failed\n", failures);
+        return 1;
+    }
+
+    return 0;
+}
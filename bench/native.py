@@ -0,0 +1,10 @@
+Import("env")
+
+
+# the display drivers in the GFX library need SPI and I2C which don't exist on the host
+def skip(node):
+    return None
+
+
+env.AddBuildMiddleware(skip, "*/Adafruit_SPITFT.cpp")
+env.AddBuildMiddleware(skip, "*/Adafruit_GrayOLED.cpp")
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// flash and ram are the same on the host
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
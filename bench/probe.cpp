@@ -0,0 +1,130 @@
+#include "probe.h"
+
+#include <cstdarg>
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+#include <string.h>
+
+#undef sscanf
+#undef mktime
+
+ProbeCounters probeCounters;
+
+int probeSscanf(const char* str, const char* format, ...)
+{
+    probeCounters.sscanf++;
+    va_list args;
+    va_start(args, format);
+    int result = vsscanf(str, format, args);
+    va_end(args);
+    return result;
+}
+
+time_t probeMktime(tm* time)
+{
+    probeCounters.mktime++;
+    return mktime(time);
+}
+
+// the heap is tracked by prefixing every allocation with its size
+static size_t heapCurrent = 0;
+static size_t heapPeak = 0;
+static size_t heapBase = 0;
+static const size_t HEAP_HEADER = alignof(max_align_t);
+
+void* operator new(size_t size)
+{
+    auto block = (uint8_t*)malloc(size + HEAP_HEADER);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    *(size_t*)block = size;
+    heapCurrent += size;
+    if (heapCurrent > heapPeak) {
+        heapPeak = heapCurrent;
+    }
+
+    return block + HEAP_HEADER;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto block = (uint8_t*)pointer - HEAP_HEADER;
+    heapCurrent -= *(size_t*)block;
+    free(block);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void probeReset()
+{
+    memset(&probeCounters, 0, sizeof(probeCounters));
+    heapBase = heapCurrent;
+    heapPeak = heapCurrent;
+}
+
+size_t probeHeapPeak()
+{
+    return heapPeak - heapBase;
+}
+
+struct StackProbe {
+    void (*func)(void*);
+    void* arg;
+};
+
+static void* runStackProbe(void* parameters)
+{
+    auto probe = (StackProbe*)parameters;
+    probe->func(probe->arg);
+    return nullptr;
+}
+
+static size_t measureStack(void (*func)(void*), void* arg)
+{
+    // the thread stack is painted with a pattern, everything that isn't the pattern anymore was used
+    const size_t stackSize = 256 * 1024;
+    const uint8_t paint = 0xA5;
+    auto stack = (uint8_t*)malloc(stackSize);
+    memset(stack, paint, stackSize);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstack(&attributes, stack, stackSize);
+
+    StackProbe probe = { func, arg };
+    pthread_t thread;
+    pthread_create(&thread, &attributes, runStackProbe, &probe);
+    pthread_join(thread, nullptr);
+    pthread_attr_destroy(&attributes);
+
+    // the stack grows down so the untouched area is at the start of the allocation
+    size_t untouched = 0;
+    while (untouched < stackSize && stack[untouched] == paint) {
+        untouched++;
+    }
+
+    free(stack);
+    return stackSize - untouched;
+}
+
+static void emptyStackProbe(void*)
+{
+}
+
+size_t probeStackPeak(void (*func)(void*), void* arg)
+{
+    // the thread itself uses some stack so that is measured once and subtracted
+    static size_t baseline = measureStack(emptyStackProbe, nullptr);
+    size_t used = measureStack(func, arg);
+    return used > baseline ? used - baseline : 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// This header is force included into every translation unit of the native environment.
+// It redirects the libc calls we want to count to the probe functions,
+// so the libraries can be measured without changing their code.
+
+#ifdef __cplusplus
+
+#include <cstdio>
+#include <ctime>
+#include <stddef.h>
+#include <stdint.h>
+
+struct ProbeCounters {
+    unsigned long readBytesUntil;
+    unsigned long sscanf;
+    unsigned long mktime;
+};
+
+extern ProbeCounters probeCounters;
+
+int probeSscanf(const char* str, const char* format, ...);
+time_t probeMktime(tm* time);
+
+#define sscanf(...) probeSscanf(__VA_ARGS__)
+#define mktime(time) probeMktime(time)
+
+/**
+ * Resets all counters and the heap peak.
+ */
+void probeReset();
+
+/**
+ * Returns the highest amount of heap bytes that were allocated at the same time since the last reset.
+ */
+size_t probeHeapPeak();
+
+/**
+ * Runs the given function on a fresh thread with a painted stack
+ * and returns how many bytes of that stack were touched.
+ */
+size_t probeStackPeak(void (*func)(void*), void* arg);
+
+#endif
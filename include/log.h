@@ -1,5 +1,43 @@
 #pragma once
 #include <Arduino.h>
 
-#define LOGI(tag, ...) Serial.printf("I (%u) %s: ", esp_log_timestamp(), tag); Serial.printf(__VA_ARGS__); Serial.println();
-#define LOGE(tag, ...) Serial.printf("E (%u) %s: ", esp_log_timestamp(), tag); Serial.printf(__VA_ARGS__); Serial.println();
\ No newline at end of file
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+// everything above this level isn't even compiled
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifdef LOG_DEFERRED
+// the lines are only recorded and written by flushLog or dumpLog, see logBuffer.h
+// only the pointers of %s arguments are recorded, so they must be literals or constant strings,
+// a char buffer doesn't compile and a String is logged as "<not a constant string>"
+#include "logBuffer.h"
+#define LOG_WRITE(level, tag, ...) deferLog(level, esp_log_timestamp(), tag, __VA_ARGS__)
+// for a string buffer that is still there when the log is flushed
+#define LOG_KEPT(string) (LogKeptString { string })
+#else
+#define LOG_KEPT(string) (string)
+#define LOG_WRITE(level, tag, ...) Serial.printf("%c (%u) %s: ", level, esp_log_timestamp(), tag); Serial.printf(__VA_ARGS__); Serial.println();
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOGE(tag, ...) do { LOG_WRITE('E', tag, __VA_ARGS__); } while (0)
+#else
+#define LOGE(tag, ...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOGI(tag, ...) do { LOG_WRITE('I', tag, __VA_ARGS__); } while (0)
+#else
+#define LOGI(tag, ...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOGD(tag, ...) do { LOG_WRITE('D', tag, __VA_ARGS__); } while (0)
+#else
+#define LOGD(tag, ...) do { } while (0)
+#endif
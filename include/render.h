@@ -7,10 +7,16 @@
 #include <GxEPD2.h>
 #include <time.h>
 
+#include "canvas.h"
+#include "civil.h"
 #include "dither.h"
 #include "iCal.h"
 #include "image.h"
+#include "layout.h"
 #include "log.h"
+#include "profiler.h"
+#include "schedule.h"
+#include "textCache.h"
 #include "util.h"
 
 const char* WEEK_DAYS[] = { "So", "Mo", "Di", "Mi", "Do", "Fr", "Sa" };
@@ -28,81 +34,258 @@ const int16_t SMALL_LINE_HEIGHT = SMALL_FONT.yAdvance + 2;
 const int16_t SMALL_LINE_DISTANCE = SMALL_LINE_HEIGHT / 2;
 const int16_t SMALL_PADDING = 2;
 
-void renderTextCentered(Adafruit_GFX& canvas, uint16_t cw, const char* message)
+// measures from the glyph arrays, so the layout doesn't need to rasterize anything
+constexpr FontMetrics LARGE_METRICS(LARGE_FONT);
+constexpr FontMetrics LARGE_BOLD_METRICS(LARGE_FONT_BOLD);
+constexpr FontMetrics SMALL_METRICS(SMALL_FONT);
+static_assert(LAYOUT_TEXT_SIZE >= ICAL_SUMMARY_SIZE + sizeof(LAYOUT_ELLIPSIS) - 1, "a summary with ellipsis must fit into a display item");
+
+// a paged canvas prints every text once per page, only then the rasterized texts are kept, see reserveTextCache
+// the widths of texts don't need the cache, they come from the font metrics on every canvas
+TextCache<LAYOUT_LIST_SIZE> textCache;
+
+/**
+ * The metrics of one of the fonts of the calender, nullptr for any other font.
+ */
+const FontMetrics* fontMetrics(const GFXfont* font)
+{
+    for (auto metrics : { &LARGE_METRICS, &LARGE_BOLD_METRICS, &SMALL_METRICS }) {
+        if (metrics->font == font) {
+            return metrics;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Makes room for every text of the display list in the text cache if the canvas is drawn page by page.
+ * Without pages every text is printed once per frame, rasterizing it first would only cost time and memory.
+ */
+template <int16_t W, int16_t H, int16_t P>
+void reserveTextCache(const Canvas3C<W, H, P>& canvas, const DisplayList& list)
+{
+    if (P >= H) {
+        return;
+    }
+
+    // the box of a text is at least as large as its bounds
+    size_t size = 0;
+    for (size_t i = 0; i < list.count; ++i) {
+        const DisplayItem& item = list.items[i];
+        if (item.kind == ITEM_TEXT) {
+            size += TextRaster::size(item.dim.x, item.dim.y, canvas.getRotation()) + strlen(item.text) + 1;
+        }
+    }
+    textCache.reserve(size);
+}
+
+/**
+ * Prints the text at the cursor, like canvas.print.
+ */
+void printText(Adafruit_GFX& canvas, const char* text)
+{
+    canvas.print(text);
+}
+
+/**
+ * Prints the text at the cursor from the text cache if the canvas has pages.
+ * Wrapped text isn't cached since the wrapping depends on the cursor position.
+ */
+template <int16_t W, int16_t H, int16_t P>
+void printText(Canvas3C<W, H, P>& canvas, const char* text)
+{
+    auto run = P >= H || canvas.getTextWrap() || !canvas.getFont() ? nullptr : textCache.get(canvas, canvas.getFont(), text);
+    if (run == nullptr) {
+        canvas.print(text);
+        return;
+    }
+
+    xy_t pos = { (int16_t)(canvas.getCursorX() + run->x), (int16_t)(canvas.getCursorY() + run->y) };
+    canvas.drawPanelBitmap(pos, { (int16_t)run->width, (int16_t)run->height }, textCache.bitmap(*run), canvas.getTextColor());
+    canvas.setCursor(canvas.getCursorX() + run->advance, canvas.getCursorY());
+}
+
+uint16_t textWidth(Adafruit_GFX& canvas, const char* text)
 {
     int16_t bx, by;
     uint16_t tw, th;
-    canvas.getTextBounds(message, canvas.getCursorX(), canvas.getCursorY(), &bx, &by, &tw, &th);
+    canvas.getTextBounds(text, canvas.getCursorX(), canvas.getCursorY(), &bx, &by, &tw, &th);
+    return tw;
+}
+
+/**
+ * The width of the text from the font metrics, like the boxes of the layout.
+ * Only text that wraps or is in another font is measured with getTextBounds.
+ */
+template <int16_t W, int16_t H, int16_t P>
+uint16_t textWidth(Canvas3C<W, H, P>& canvas, const char* text)
+{
+    auto metrics = fontMetrics(canvas.getFont());
+    if (metrics == nullptr) {
+        return textWidth(static_cast<Adafruit_GFX&>(canvas), text);
+    }
+
+    int16_t width = metrics->width(text, strlen(text)) - metrics->left(text);
+    if (canvas.getTextWrap() && canvas.getCursorX() + width > canvas.width()) {
+        return textWidth(static_cast<Adafruit_GFX&>(canvas), text);
+    }
+
+    return width;
+}
+
+template <typename Canvas>
+void renderTextCentered(Canvas& canvas, uint16_t cw, const char* message)
+{
+    uint16_t tw = textWidth(canvas, message);
     canvas.setCursor(canvas.getCursorX() + cw / 2 - tw / 2, canvas.getCursorY());
-    canvas.print(message);
+    printText(canvas, message);
 }
 
-void renderCalender(Adafruit_GFX& canvas, time_t timestamp, ICalEntry* entries, size_t size)
+/**
+ * The layout pass of renderCalender, it only decides what goes where.
+ * Lines are only laid out as long as they start above bottom, below that nothing would be visible.
+ * Summaries wider than the canvas are cut with an ellipsis.
+ * The summaries are printed in the color of their source if sourceColors is given.
+ */
+void layoutCalender(DisplayList& list, int16_t width, int16_t bottom, time_t timestamp, ICalEntry* entries, size_t size, const uint16_t* sourceColors = nullptr)
 {
-    canvas.setTextWrap(false);
-    canvas.setFont(&LARGE_FONT); // set the font before the first cursor set to avoid the 6px move by switching between font types
-    canvas.setCursor(LARGE_PADDING, LARGE_LINE_HEIGHT - LARGE_LINE_DISTANCE / 2);
+    list.clear();
 
-    tm currentTime;
-    localtime_r(&timestamp, &currentTime);
-    int currentDay = calculateDaystamp(currentTime);
-    int lastDay = 0;
+    int16_t maxWidth = width - LARGE_PADDING * 2;
+    int16_t cursorY = LARGE_LINE_HEIGHT - LARGE_LINE_DISTANCE / 2;
+    int32_t currentDay = localDays(timestamp);
+    int32_t lastDay = 0;
     for (size_t i = 0; i < size; ++i) {
-        tm entryTime;
-        localtime_r(&entries[i].start, &entryTime);
-        int entryDay = calculateDaystamp(entryTime);
+        int32_t entryDay = entries[i].day;
         int dayOffset = entryDay - currentDay;
-        LOGI("render", "render day offset %d with entry day %d", dayOffset, entryDay);
+        LOGD("render", "layout day offset %d with entry day %d", dayOffset, (int)entryDay);
 
-        // draw header
+        // the header
         if (lastDay != entryDay) {
             lastDay = entryDay;
 
             if (i > 0) {
-                canvas.setCursor(LARGE_PADDING, canvas.getCursorY() + LARGE_LINE_DISTANCE / 2);
+                cursorY += LARGE_LINE_DISTANCE / 2;
             }
 
-            canvas.setTextColor(GxEPD_WHITE);
-            canvas.setFont(&LARGE_FONT_BOLD);
-
-            xy_t headerPos = { 0, (int16_t)(canvas.getCursorY() + LARGE_LINE_DISTANCE / 2 - LARGE_LINE_HEIGHT) };
-            xy_t headerDim = { canvas.width(), LARGE_LINE_HEIGHT };
-            if (dayOffset == 0) {
-                drawGradientX(canvas, headerPos, headerDim, COLORSPACE_3C, GxEPD_BLACK, GxEPD_RED);
-                canvas.print("Heute");
-            } else if (dayOffset == 1) {
-                drawGradientX(canvas, headerPos, headerDim, COLORSPACE_3C, GxEPD_BLACK, GxEPD_RED);
-                canvas.print("Morgen");
-            } else if (dayOffset <= 3) {
-                drawGradientX(canvas, headerPos, headerDim, COLORSPACE_3C, GxEPD_BLACK, GxEPD_RED);
-                canvas.print(LONG_WEEK_DAYS[entryTime.tm_wday]);
+            int16_t top = cursorY + LARGE_LINE_DISTANCE / 2 - LARGE_LINE_HEIGHT;
+            if (top >= bottom) {
+                list.overflow = true;
+                break;
+            }
+
+            xy_t headerPos = { 0, top };
+            xy_t headerDim = { width, (int16_t)(top + LARGE_LINE_HEIGHT < bottom ? LARGE_LINE_HEIGHT : bottom - top) };
+            xy_t cursor = { LARGE_PADDING, cursorY };
+            if (dayOffset <= SCHEDULE_WEEKDAY_DAYS) {
+                auto gradient = list.add(ITEM_GRADIENT_3C, headerPos, headerDim);
+                if (gradient != nullptr) {
+                    gradient->color = GxEPD_BLACK;
+                    gradient->color2 = GxEPD_RED;
+                }
+                const char* name = dayOffset == 0 ? "Heute" : dayOffset == 1 ? "Morgen" : LONG_WEEK_DAYS[weekdayFromDays(entryDay)];
+                list.addText(LARGE_BOLD_METRICS, cursor, top, top + LARGE_LINE_HEIGHT, GxEPD_WHITE, name, maxWidth);
             } else {
-                drawGradientX(canvas, headerPos, headerDim, COLORSPACE_2C, GxEPD_BLACK, mix(GxEPD_BLACK, GxEPD_WHITE, 128));
-                canvas.printf("%s %02d. %s", WEEK_DAYS[entryTime.tm_wday], entryTime.tm_mday, MONTHS[entryTime.tm_mon]);
+                auto gradient = list.add(ITEM_GRADIENT_2C, headerPos, headerDim);
+                if (gradient != nullptr) {
+                    gradient->color = GxEPD_BLACK;
+                    gradient->color2 = mix(GxEPD_BLACK, GxEPD_WHITE, 128);
+                }
+
+                // only the day number changes, the names come from the text cache
+                CivilDate date = civilFromDays(entryDay);
+                char number[8];
+                snprintf(number, sizeof(number), " %02d. ", date.day);
+                for (const char* part : { WEEK_DAYS[weekdayFromDays(entryDay)], (const char*)number, MONTHS[date.month - 1] }) {
+                    list.addText(LARGE_BOLD_METRICS, cursor, top, top + LARGE_LINE_HEIGHT, GxEPD_WHITE, part, maxWidth - (cursor.x - LARGE_PADDING));
+                    cursor.x += LARGE_BOLD_METRICS.advance(part, strlen(part));
+                }
             }
 
-            canvas.setCursor(LARGE_PADDING, canvas.getCursorY() + LARGE_LINE_HEIGHT);
+            cursorY += LARGE_LINE_HEIGHT;
         }
 
-        canvas.setTextColor(GxEPD_BLACK);
-        canvas.setFont(&LARGE_FONT);
-        canvas.print(entries[i].summary);
+        // the summary
+        int16_t top = cursorY + LARGE_LINE_DISTANCE / 2 - LARGE_LINE_HEIGHT;
+        color_t color = sourceColors != nullptr ? sourceColors[entries[i].source] : GxEPD_BLACK;
+        if (top >= bottom || list.addText(LARGE_METRICS, { LARGE_PADDING, cursorY }, top, top + LARGE_LINE_HEIGHT, color, icalSummary(entries[i].summary), maxWidth) == nullptr) {
+            list.overflow = true;
+            break;
+        }
 
-        canvas.setCursor(LARGE_PADDING, canvas.getCursorY() + LARGE_LINE_HEIGHT);
-        if (canvas.getCursorY() > canvas.height() + LARGE_LINE_HEIGHT) {
+        if (top + LARGE_LINE_HEIGHT > bottom) {
+            list.overflow = true;
             break;
         }
+
+        list.fitCount = i + 1;
+        cursorY += LARGE_LINE_HEIGHT;
+    }
+
+    list.overflow |= list.fitCount < size;
+    if (list.overflow) {
+        // fade the last entries out so it's visible that the list goes on
+        list.fadeBand({ 0, (int16_t)(bottom - 64) }, { width, 64 }, GxEPD_BLACK, mix(GxEPD_BLACK, GxEPD_WHITE, 170));
     }
+}
 
-    loopRect({ 0, (int16_t)(canvas.height() - 64) }, { canvas.width(), 64 }, [&canvas](xy_t relPos, xy_t pos) {
-        auto color = dither(pos, COLORSPACE_2C, mix(GxEPD_BLACK, GxEPD_WHITE, relPos.y * 255 / 95));
-        if (color == GxEPD_WHITE) {
-            canvas.drawPixel(pos.x, pos.y, GxEPD_WHITE);
+/**
+ * The draw pass, executes the display list in order.
+ * Templated on the canvas so the dither functions can use the fast path of the canvas if it has one.
+ */
+template <typename Canvas>
+void drawDisplayList(Canvas& canvas, const DisplayList& list)
+{
+    canvas.setTextWrap(false);
+    for (size_t i = 0; i < list.count; ++i) {
+        const DisplayItem& item = list.items[i];
+        switch (item.kind) {
+        case ITEM_TEXT:
+            canvas.setFont(item.font); // set the font before the cursor to avoid the 6px move by switching between font types
+            canvas.setTextColor(item.color);
+            canvas.setCursor(item.cursor.x, item.cursor.y);
+            printText(canvas, item.text);
+            break;
+        case ITEM_GRADIENT_2C:
+            drawGradientX(canvas, item.pos, item.dim, COLORSPACE_2C, item.color, item.color2);
+            break;
+        case ITEM_GRADIENT_3C:
+            drawGradientX(canvas, item.pos, item.dim, COLORSPACE_3C, item.color, item.color2);
+            break;
+        case ITEM_FADE_2C:
+            drawFadeY(canvas, item.bandPos, item.bandDim, item.pos, item.dim, COLORSPACE_2C, item.color, item.color2);
+            break;
         }
-    });
+    }
+}
+
+/**
+ * Where the calender ends above the footer on a canvas of the given height.
+ * If only the bands above the footer are compared, pass the band height so the calender ends at a band boundary,
+ * otherwise its last rows would share a band with the footer and a change in them would be missed.
+ */
+int16_t calenderBottom(int16_t height, int16_t bandHeight = 1)
+{
+    int16_t bottom = height - SMALL_LINE_HEIGHT;
+    return bottom - bottom % bandHeight;
 }
 
-void renderError(Adafruit_GFX& canvas, const char* title, const char* message)
+// the layout pass is done before anything is drawn, so the list doesn't need to be on the stack
+DisplayList calenderList;
+
+/**
+ * Lays the calender out and draws it. Only lines above bottom are drawn, like the space above the footer.
+ */
+template <typename Canvas>
+void renderCalender(Canvas& canvas, time_t timestamp, ICalEntry* entries, size_t size, const uint16_t* sourceColors = nullptr, int16_t bottom = INT16_MAX)
+{
+    layoutCalender(calenderList, canvas.width(), bottom < canvas.height() ? bottom : canvas.height(), timestamp, entries, size, sourceColors);
+    drawDisplayList(canvas, calenderList);
+}
+
+template <typename Canvas>
+void renderError(Canvas& canvas, const char* title, const char* message)
 {
     canvas.drawBitmap(
         canvas.width() / 2 - exclamation.width / 2,
@@ -124,10 +307,38 @@ void renderError(Adafruit_GFX& canvas, const char* title, const char* message)
     renderTextCentered(canvas, canvas.width(), message);
 }
 
-void renderFooter(Adafruit_GFX& canvas, time_t timestamp, unsigned sleepTime, unsigned voltage)
+/**
+ * Draws the awake time of the last wake cycles as tiny bars behind the text of the footer.
+ * Only as many cycles as fit in the rest of the line are shown, the newest ones.
+ */
+void renderProfile(Adafruit_GFX& canvas, const ProfileLog& profile)
 {
-    tm currentTime;
-    localtime_r(&timestamp, &currentTime);
+    uint16_t maxAwake = 1;
+    for (size_t age = 0; age < PROFILE_CYCLES; ++age) {
+        auto cycle = profileCycle(profile, age);
+        if (cycle != nullptr && cycle->start[PHASE_SLEEP] != PROFILE_UNUSED && cycle->start[PHASE_SLEEP] > maxAwake) {
+            maxAwake = cycle->start[PHASE_SLEEP];
+        }
+    }
+
+    int16_t left = canvas.getCursorX() + SMALL_PADDING * 2;
+    int16_t space = canvas.width() - SMALL_PADDING - left;
+    size_t count = space > 0 ? space / 3 : 0;
+    count = count < PROFILE_CYCLES ? count : PROFILE_CYCLES;
+    int16_t bottom = canvas.height() - 1;
+    int16_t x = left;
+    for (size_t age = count; age-- > 0; x += 3) {
+        auto cycle = profileCycle(profile, age);
+        if (cycle != nullptr && cycle->start[PHASE_SLEEP] != PROFILE_UNUSED) {
+            int16_t height = 1 + cycle->start[PHASE_SLEEP] * (SMALL_LINE_HEIGHT - 3) / maxAwake;
+            canvas.fillRect(x, bottom - height, 2, height, GxEPD_BLACK);
+        }
+    }
+}
+
+void renderFooter(Adafruit_GFX& canvas, time_t timestamp, unsigned sleepTime, unsigned voltage, int32_t daysLeft = -1, const ProfileLog* profile = nullptr)
+{
+    LocalTime currentTime = toLocalTime(timestamp);
 
     canvas.setFont(&SMALL_FONT);
     canvas.setTextColor(GxEPD_BLACK);
@@ -135,13 +346,13 @@ void renderFooter(Adafruit_GFX& canvas, time_t timestamp, unsigned sleepTime, un
     canvas.setCursor(SMALL_PADDING, canvas.height() - (SMALL_LINE_HEIGHT - SMALL_FONT.yAdvance));
     canvas.print("aktuallisiert ");
     canvas.printf("%s %02d. %s %04d %02d:%02d:%02d",
-        LONG_WEEK_DAYS[currentTime.tm_wday],
-        currentTime.tm_mday,
-        MONTHS[currentTime.tm_mon],
-        currentTime.tm_year + 1900,
-        currentTime.tm_hour,
-        currentTime.tm_min,
-        currentTime.tm_sec);
+        LONG_WEEK_DAYS[currentTime.weekday],
+        currentTime.date.day,
+        MONTHS[currentTime.date.month - 1],
+        currentTime.date.year,
+        currentTime.hour,
+        currentTime.minute,
+        currentTime.second);
 
     canvas.setTextColor(sleepTime < (3600 * 4) ? GxEPD_RED : GxEPD_BLACK);
     canvas.printf(", naechstes %u:%02u:%02u", sleepTime / 3600, sleepTime / 60 % 60, sleepTime % 60);
@@ -150,4 +361,12 @@ void renderFooter(Adafruit_GFX& canvas, time_t timestamp, unsigned sleepTime, un
         canvas.setTextColor(voltage < 3200 ? GxEPD_RED : GxEPD_BLACK);
         canvas.printf(", %u.%03u V", voltage / 1000, voltage % 1000);
     }
+    if (daysLeft >= 0) {
+        canvas.setTextColor(daysLeft < 30 ? GxEPD_RED : GxEPD_BLACK);
+        canvas.printf(", noch ~%d Tage", (int)daysLeft);
+    }
+
+    if (profile != nullptr) {
+        renderProfile(canvas, *profile);
+    }
 }
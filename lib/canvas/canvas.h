@@ -0,0 +1,594 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <GxEPD2.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "dither.h"
+
+/**
+ * A 3 color frame buffer with the same memory layout as the one in GxEPD2_3C.
+ * Other than GxEPD2_3C, the buffers are accessible,
+ * so the frame can be inspected before it is written to the panel with epd2.writeImage.
+ *
+ * The canvas is split into bands of BAND_HEIGHT rows (in canvas coordinates)
+ * and remembers which bands were drawn to since the last fillScreen.
+ * Bands are aligned to bytes of the buffer in every rotation, so each one can be sent to the panel on its own.
+ *
+ * With a PAGE_HEIGHT below PANEL_HEIGHT the buffer only holds that many rows of the panel, like the paged mode of GxEPD2.
+ * Everything outside the current page is skipped, so a frame is drawn once per page, see drawPages.
+ */
+template <int16_t PANEL_WIDTH, int16_t PANEL_HEIGHT, int16_t PAGE_HEIGHT = PANEL_HEIGHT>
+class Canvas3C : public Adafruit_GFX {
+public:
+    static const uint16_t WIDTH_BYTES = PANEL_WIDTH / 8;
+    static const uint16_t BUFFER_SIZE = WIDTH_BYTES * PAGE_HEIGHT;
+    static const uint16_t PAGE_COUNT = (PANEL_HEIGHT + PAGE_HEIGHT - 1) / PAGE_HEIGHT;
+    static const int16_t BAND_HEIGHT = 8;
+    static const int16_t MAX_LENGTH = PANEL_WIDTH > PANEL_HEIGHT ? PANEL_WIDTH : PANEL_HEIGHT;
+    static const uint16_t MAX_BANDS = (MAX_LENGTH + BAND_HEIGHT - 1) / BAND_HEIGHT;
+
+    Canvas3C()
+        : Adafruit_GFX(PANEL_WIDTH, PANEL_HEIGHT)
+    {
+        fillScreen(GxEPD_WHITE);
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || x >= width() || y < 0 || y >= height()) {
+            return;
+        }
+
+        uint16_t band = y / BAND_HEIGHT;
+        toPanel(x, y);
+        if (y < pageY || y >= pageY + PAGE_HEIGHT) {
+            return;
+        }
+
+        dirtyBands[band / 8] |= 1 << (band % 8);
+        uint16_t i = x / 8 + (y - pageY) * WIDTH_BYTES;
+        uint8_t mask = 1 << (7 - x % 8);
+        if (color == GxEPD_WHITE) {
+            blackBuffer[i] |= mask;
+            colorBuffer[i] |= mask;
+        } else if (color == GxEPD_RED || color == GxEPD_YELLOW) {
+            blackBuffer[i] |= mask;
+            colorBuffer[i] &= ~mask;
+        } else {
+            blackBuffer[i] &= ~mask;
+            colorBuffer[i] |= mask;
+        }
+    }
+
+    /**
+     * Reads a pixel back as GxEPD_BLACK, GxEPD_WHITE or GxEPD_RED, pixels outside of the page are white.
+     */
+    uint16_t getPixel(int16_t x, int16_t y) const
+    {
+        if (x < 0 || x >= width() || y < 0 || y >= height()) {
+            return GxEPD_WHITE;
+        }
+
+        toPanel(x, y);
+        if (y < pageY || y >= pageY + PAGE_HEIGHT) {
+            return GxEPD_WHITE;
+        }
+
+        uint16_t i = x / 8 + (y - pageY) * WIDTH_BYTES;
+        uint8_t mask = 1 << (7 - x % 8);
+        if (!(colorBuffer[i] & mask)) {
+            return GxEPD_RED;
+        }
+
+        return blackBuffer[i] & mask ? GxEPD_WHITE : GxEPD_BLACK;
+    }
+
+    /**
+     * Draws a 1 bit bitmap that is already in the orientation of the panel, like the ones of TextRaster.
+     * pos and size are in canvas coordinates. Set bits get the color, the rest is left untouched.
+     * Each byte of the bitmap is written with at most 2 byte operations.
+     */
+    void drawPanelBitmap(xy_t pos, xy_t size, const uint8_t* bitmap, uint16_t color)
+    {
+        if (size.x <= 0 || size.y <= 0) {
+            return;
+        }
+
+        int16_t fromBand = (pos.y > 0 ? pos.y : 0) / BAND_HEIGHT;
+        int16_t toBand = (pos.y + size.y - 1 < height() ? pos.y + size.y - 1 : height() - 1) / BAND_HEIGHT;
+        for (int16_t band = fromBand; band <= toBand; ++band) {
+            dirtyBands[band / 8] |= 1 << (band % 8);
+        }
+
+        int16_t x1 = pos.x, y1 = pos.y;
+        int16_t x2 = pos.x + size.x - 1, y2 = pos.y + size.y - 1;
+        toPanel(x1, y1);
+        toPanel(x2, y2);
+        xy_t panelPos = { x1 < x2 ? x1 : x2, y1 < y2 ? y1 : y2 };
+        xy_t panelSize = { (int16_t)(x1 < x2 ? x2 - x1 + 1 : x1 - x2 + 1), (int16_t)(y1 < y2 ? y2 - y1 + 1 : y1 - y2 + 1) };
+
+        uint16_t stride = (panelSize.x + 7) / 8;
+        for (int16_t row = 0; row < panelSize.y; ++row) {
+            int16_t y = panelPos.y + row;
+            if (y < pageY || y >= pageEnd()) {
+                continue;
+            }
+
+            for (uint16_t column = 0; column < stride; ++column) {
+                uint8_t bits = bitmap[column + row * stride];
+                if (bits == 0) {
+                    continue;
+                }
+
+                // the bitmap isn't aligned to the bytes of the buffer, so each byte is split in 2
+                int16_t x = panelPos.x + column * 8;
+                uint8_t shift = x & 7;
+                int16_t target = (x - shift) / 8;
+                setBits(target, y, bits >> shift, color);
+                if (shift > 0) {
+                    setBits(target + 1, y, bits << (8 - shift), color);
+                }
+            }
+        }
+    }
+
+    const GFXfont* getFont() const
+    {
+        return gfxFont;
+    }
+
+    uint16_t getTextColor() const
+    {
+        return textcolor;
+    }
+
+    bool getTextWrap() const
+    {
+        return wrap;
+    }
+
+    /**
+     * Moves the buffer to the given page, clear it with fillScreen before drawing the page.
+     */
+    void setPage(uint16_t page)
+    {
+        pageY = page * PAGE_HEIGHT;
+    }
+
+    /**
+     * The first row of the panel that is in the buffer.
+     */
+    int16_t getPageY() const
+    {
+        return pageY;
+    }
+
+    /**
+     * The rows of the panel that are in the buffer, the last page may be shorter than PAGE_HEIGHT.
+     */
+    int16_t getPageRows() const
+    {
+        return pageEnd() - pageY;
+    }
+
+    void fillScreen(uint16_t color) override
+    {
+        fillColor = color;
+        memset(dirtyBands, 0, sizeof(dirtyBands));
+        memset(blackBuffer, color == GxEPD_WHITE || color == GxEPD_RED || color == GxEPD_YELLOW ? 0xFF : 0x00, BUFFER_SIZE);
+        memset(colorBuffer, color == GxEPD_RED || color == GxEPD_YELLOW ? 0x00 : 0xFF, BUFFER_SIZE);
+    }
+
+    /**
+     * Converts rotated canvas coordinates into coordinates of the panel buffer.
+     */
+    void toPanel(int16_t& x, int16_t& y) const
+    {
+        int16_t t;
+        switch (getRotation()) {
+        case 1:
+            t = x;
+            x = PANEL_WIDTH - y - 1;
+            y = t;
+            break;
+        case 2:
+            x = PANEL_WIDTH - x - 1;
+            y = PANEL_HEIGHT - y - 1;
+            break;
+        case 3:
+            t = x;
+            x = y;
+            y = PANEL_HEIGHT - t - 1;
+            break;
+        }
+    }
+
+    /**
+     * Converts coordinates of the panel buffer back into rotated canvas coordinates.
+     */
+    void fromPanel(int16_t& x, int16_t& y) const
+    {
+        int16_t t;
+        switch (getRotation()) {
+        case 1:
+            t = x;
+            x = y;
+            y = PANEL_WIDTH - t - 1;
+            break;
+        case 2:
+            x = PANEL_WIDTH - x - 1;
+            y = PANEL_HEIGHT - y - 1;
+            break;
+        case 3:
+            t = x;
+            x = PANEL_HEIGHT - y - 1;
+            y = t;
+            break;
+        }
+    }
+
+    /**
+     * Converts a rectangle in canvas coordinates into a rectangle of the panel buffer.
+     * The rectangle is clipped to the panel and widened to full bytes.
+     */
+    void toPanel(xy_t& pos, xy_t& size) const
+    {
+        int16_t x1 = pos.x, y1 = pos.y;
+        int16_t x2 = pos.x + size.x - 1, y2 = pos.y + size.y - 1;
+        toPanel(x1, y1);
+        toPanel(x2, y2);
+
+        pos.x = clamp(x1 < x2 ? x1 : x2, PANEL_WIDTH) / 8 * 8;
+        pos.y = clamp(y1 < y2 ? y1 : y2, PANEL_HEIGHT);
+        size.x = clamp(x1 < x2 ? x2 : x1, PANEL_WIDTH) / 8 * 8 + 8 - pos.x;
+        size.y = clamp(y1 < y2 ? y2 : y1, PANEL_HEIGHT) + 1 - pos.y;
+    }
+
+    /**
+     * Calculates a FNV-1a hash over both color planes within the given rectangle (in canvas coordinates).
+     * The rectangle is widened to full bytes of the buffer.
+     * This is meant to find out if the frame differs from the one that is already on the panel.
+     * Only the rows of the current page are hashed, pass the hash of the previous page to continue it.
+     */
+    uint32_t digest(xy_t pos, xy_t size, uint32_t hash = 2166136261) const
+    {
+        toPanel(pos, size);
+
+        int16_t fromRow = pos.y > pageY ? pos.y : pageY;
+        int16_t toRow = pos.y + size.y < pageEnd() ? pos.y + size.y : pageEnd();
+        for (int16_t row = fromRow; row < toRow; ++row) {
+            uint16_t from = (row - pageY) * WIDTH_BYTES + pos.x / 8;
+            for (uint16_t i = from; i < from + size.x / 8; ++i) {
+                hash = (hash ^ blackBuffer[i]) * 16777619;
+                hash = (hash ^ colorBuffer[i]) * 16777619;
+            }
+        }
+
+        return hash;
+    }
+
+    uint32_t digest() const
+    {
+        return digest({ 0, 0 }, { width(), height() });
+    }
+
+    /**
+     * Fills a rectangle (in canvas coordinates) with a dithered gradient from c1 to c2 along x or y.
+     * This writes 8 pixels of the buffer at once instead of going through drawPixel.
+     * If the gradient doesn't change within those 8 pixels, all of them are dithered with a single table lookup,
+     * otherwise the bytes of the first 8 rows are dithered bit by bit and repeated for the rest.
+     * With fade, pixels that would get c1 are left untouched.
+     */
+    template <size_t N>
+    void ditherGradient(xy_t pos, xy_t size, const Palette<N>& palette, color_t c1, color_t c2, bool vertical, bool fade = false)
+    {
+        ditherGradient(pos, size, { 0, 0 }, { width(), height() }, palette, c1, c2, vertical, fade);
+    }
+
+    /**
+     * Like ditherGradient but only the part of the gradient within the clip rectangle is drawn.
+     */
+    template <size_t N>
+    void ditherGradient(xy_t pos, xy_t size, xy_t clipPos, xy_t clipSize, const Palette<N>& palette, color_t c1, color_t c2, bool vertical, bool fade = false)
+    {
+        int16_t left = clipPos.x > 0 ? clipPos.x : 0, top = clipPos.y > 0 ? clipPos.y : 0;
+        int16_t right = clipPos.x + clipSize.x < width() ? clipPos.x + clipSize.x : width();
+        int16_t bottom = clipPos.y + clipSize.y < height() ? clipPos.y + clipSize.y : height();
+        xy_t from = { pos.x > left ? pos.x : left, pos.y > top ? pos.y : top };
+        xy_t to = {
+            (int16_t)((pos.x + size.x < right ? pos.x + size.x : right) - 1),
+            (int16_t)((pos.y + size.y < bottom ? pos.y + size.y : bottom) - 1),
+        };
+        if (from.x > to.x || from.y > to.y) {
+            return;
+        }
+
+        for (int16_t band = from.y / BAND_HEIGHT; band <= to.y / BAND_HEIGHT; ++band) {
+            dirtyBands[band / 8] |= 1 << (band % 8);
+        }
+
+        // the color only changes along one axis, so it's only dithered once per position on that axis
+        int16_t length = vertical ? size.y : size.x;
+        int16_t first = vertical ? from.y - pos.y : from.x - pos.x;
+        int16_t last = vertical ? to.y - pos.y : to.x - pos.x;
+        DitherLevel* levels = ditherLevels;
+        // a gradient longer than 256 pixels has runs of the same ratio
+        int16_t lastRatio = -1;
+        for (int16_t i = first; i <= last; ++i) {
+            int16_t ratio = length > 1 ? i * 255 / (length - 1) : 0;
+            levels[i - first] = ratio == lastRatio ? levels[i - first - 1] : ditherLevel(palette, mix(c1, c2, ratio));
+            lastRatio = ratio;
+        }
+
+        uint8_t blackBits[N], colorBits[N];
+        for (size_t i = 0; i < N; ++i) {
+            bool red = palette.colors[i] == GxEPD_RED || palette.colors[i] == GxEPD_YELLOW;
+            blackBits[i] = red || palette.colors[i] == GxEPD_WHITE ? 0xFF : 0x00;
+            colorBits[i] = red ? 0x00 : 0xFF;
+        }
+
+        // the 8 pixels of a byte are along y in canvas coordinates if the canvas is rotated by 90 degrees
+        // with rotation 1 and 2 they are in reverse order
+        uint8_t rotation = getRotation();
+        bool alongY = rotation % 2 == 1;
+        bool reversed = rotation == 1 || rotation == 2;
+        bool sameLevel = alongY != vertical;
+
+        int16_t x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+        toPanel(x1, y1);
+        toPanel(x2, y2);
+        int16_t fromX = x1 < x2 ? x1 : x2, toX = x1 < x2 ? x2 : x1;
+        int16_t fromY = y1 < y2 ? y1 : y2, toY = y1 < y2 ? y2 : y1;
+        fromY = fromY > pageY ? fromY : pageY;
+        toY = toY < pageEnd() - 1 ? toY : pageEnd() - 1;
+
+        // if the gradient runs across the bytes, all pixels of a row have the same level and every byte of the row is the same,
+        // otherwise every pixel of a byte has its own level, but the bytes repeat after 8 rows
+        auto repeated = ditherBytes;
+        int16_t fromColumn = fromX / 8, toColumn = toX / 8;
+        uint8_t fromMask = 0xFF >> (fromX % 8), toMask = 0xFF << (7 - toX % 8);
+
+        // each pixel takes the low color in the rows of its DITHER_MASKS entry,
+        // so the masks of the 8 pixels of a byte are transposed into one byte per row, which decides 8 pixels at once
+        if (!sameLevel) {
+            int8_t step = reversed ? -1 : 1;
+            for (int16_t column = fromColumn; column <= toColumn; ++column) {
+                uint8_t edge = (column == fromColumn ? fromMask : 0xFF) & (column == toColumn ? toMask : 0xFF);
+                int16_t x = column * 8, y = fromY;
+                fromPanel(x, y);
+                int16_t along = (vertical ? y - pos.y : x - pos.x) - first;
+                int16_t alongPattern = vertical ? y : x;
+
+                uint64_t lows = 0;
+                uint8_t lowBlack = 0, highBlack = 0, lowColor = 0, highColor = 0, lowFade = 0, highFade = 0;
+                for (uint8_t bit = 0; bit < 8; ++bit) {
+                    uint8_t pixel = 0x80 >> bit;
+                    if (!(edge & pixel)) {
+                        continue;
+                    }
+
+                    auto& level = levels[along + step * bit];
+                    uint8_t patternPos = (alongPattern + step * bit) % 8;
+                    uint8_t low = 0xFF;
+                    if (level.threshold >= 0) {
+                        low = vertical ? DITHER_MASKS.columns[patternPos][level.threshold] : DITHER_MASKS.rows[patternPos][level.threshold];
+                    }
+                    lows |= (uint64_t)low << (56 - bit * 8);
+
+                    lowBlack |= blackBits[level.low] & pixel;
+                    highBlack |= blackBits[level.high] & pixel;
+                    lowColor |= colorBits[level.low] & pixel;
+                    highColor |= colorBits[level.high] & pixel;
+                    lowFade |= fade && palette.colors[level.low] == c1 ? pixel : 0;
+                    highFade |= fade && palette.colors[level.high] == c1 ? pixel : 0;
+                }
+
+                // an 8x8 bit transpose, afterwards byte i has the bits of the pixels at position i across the gradient
+                uint64_t t = (lows ^ (lows >> 7)) & 0x00AA00AA00AA00AAULL;
+                lows ^= t ^ (t << 7);
+                t = (lows ^ (lows >> 14)) & 0x0000CCCC0000CCCCULL;
+                lows ^= t ^ (t << 14);
+                t = (lows ^ (lows >> 28)) & 0x00000000F0F0F0F0ULL;
+                lows ^= t ^ (t << 28);
+
+                for (uint8_t across = 0; across < 8; ++across) {
+                    uint8_t low = lows >> (56 - across * 8);
+                    repeated[across][column] = {
+                        (uint8_t)((low & lowBlack) | (~low & highBlack)),
+                        (uint8_t)((low & lowColor) | (~low & highColor)),
+                        (uint8_t)(edge & ~(low & lowFade) & ~(~low & highFade)),
+                    };
+                }
+            }
+        }
+
+        for (int16_t row = fromY; row <= toY; ++row) {
+            int16_t x = fromColumn * 8, y = row;
+            fromPanel(x, y);
+            DitherBytes* bytes = repeated[(vertical ? x : y) % 8];
+            if (sameLevel) {
+                auto& level = levels[(vertical ? y - pos.y : x - pos.x) - first];
+                uint8_t low = 0xFF;
+                if (level.threshold >= 0) {
+                    low = alongY ? DITHER_MASKS.rows[x % 8][level.threshold] : DITHER_MASKS.columns[y % 8][level.threshold];
+                    low = reversed ? reverseBits(low) : low;
+                }
+
+                uint8_t mask = 0xFF;
+                if (fade && palette.colors[level.low] == c1) {
+                    mask &= ~low;
+                }
+                if (fade && palette.colors[level.high] == c1) {
+                    mask &= low;
+                }
+                bytes[0] = {
+                    (uint8_t)((low & blackBits[level.low]) | (~low & blackBits[level.high])),
+                    (uint8_t)((low & colorBits[level.low]) | (~low & colorBits[level.high])),
+                    mask,
+                };
+            }
+
+            uint8_t* blackRow = blackBuffer + (row - pageY) * WIDTH_BYTES;
+            uint8_t* colorRow = colorBuffer + (row - pageY) * WIDTH_BYTES;
+            for (int16_t column = fromColumn; column <= toColumn; ++column) {
+                auto& byte = bytes[sameLevel ? 0 : column];
+                uint8_t mask = byte.mask;
+                if (sameLevel) {
+                    mask &= (column == fromColumn ? fromMask : 0xFF) & (column == toColumn ? toMask : 0xFF);
+                }
+                blackRow[column] = (blackRow[column] & ~mask) | (byte.black & mask);
+                colorRow[column] = (colorRow[column] & ~mask) | (byte.color & mask);
+            }
+        }
+    }
+
+    uint16_t bandCount() const
+    {
+        return (height() + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    }
+
+    bool isBandDirty(uint16_t band) const
+    {
+        return dirtyBands[band / 8] & (1 << (band % 8));
+    }
+
+    /**
+     * The digest of a single band.
+     * Bands that weren't drawn to since the last fillScreen aren't hashed,
+     * their digest is the fill color instead, which is cheap and still unique for the content.
+     */
+    uint32_t bandDigest(uint16_t band) const
+    {
+        if (!isBandDirty(band)) {
+            return 0xFFFF0000 | fillColor;
+        }
+
+        return digest({ 0, (int16_t)(band * BAND_HEIGHT) }, { width(), BAND_HEIGHT });
+    }
+
+    /**
+     * Draws the frame page by page and writes the digest of every band into digests,
+     * they are the same as the bandDigest of every band of a buffer that holds the whole frame.
+     * draw is called once per page and has to start with fillScreen. The last page stays in the buffer.
+     */
+    template <typename F>
+    void digestPages(uint32_t* digests, F draw)
+    {
+        uint16_t bands = bandCount();
+        if (PAGE_COUNT == 1) {
+            setPage(0);
+            draw();
+            for (uint16_t band = 0; band < bands; ++band) {
+                digests[band] = bandDigest(band);
+            }
+            return;
+        }
+
+        // a band is only blank if it is blank on every page, otherwise the hash goes on over all pages
+        uint8_t dirty[(MAX_BANDS + 7) / 8] = {};
+        for (uint16_t band = 0; band < bands; ++band) {
+            digests[band] = 2166136261;
+        }
+        for (uint16_t page = 0; page < PAGE_COUNT; ++page) {
+            setPage(page);
+            draw();
+            for (uint16_t band = 0; band < bands; ++band) {
+                dirty[band / 8] |= dirtyBands[band / 8] & (1 << (band % 8));
+                digests[band] = digest({ 0, (int16_t)(band * BAND_HEIGHT) }, { width(), BAND_HEIGHT }, digests[band]);
+            }
+        }
+        for (uint16_t band = 0; band < bands; ++band) {
+            if (!(dirty[band / 8] & (1 << (band % 8)))) {
+                digests[band] = 0xFFFF0000 | fillColor;
+            }
+        }
+    }
+
+    uint8_t blackBuffer[BUFFER_SIZE];
+    uint8_t colorBuffer[BUFFER_SIZE];
+
+private:
+    struct DitherBytes {
+        uint8_t black;
+        uint8_t color;
+        uint8_t mask;
+    };
+
+    void setBits(int16_t column, int16_t row, uint8_t mask, uint16_t color)
+    {
+        if (column < 0 || column >= WIDTH_BYTES || mask == 0) {
+            return;
+        }
+
+        uint16_t i = column + (row - pageY) * WIDTH_BYTES;
+        if (color == GxEPD_WHITE) {
+            blackBuffer[i] |= mask;
+            colorBuffer[i] |= mask;
+        } else if (color == GxEPD_RED || color == GxEPD_YELLOW) {
+            blackBuffer[i] |= mask;
+            colorBuffer[i] &= ~mask;
+        } else {
+            blackBuffer[i] &= ~mask;
+            colorBuffer[i] |= mask;
+        }
+    }
+
+    static uint8_t reverseBits(uint8_t bits)
+    {
+        bits = (bits & 0xF0) >> 4 | (bits & 0x0F) << 4;
+        bits = (bits & 0xCC) >> 2 | (bits & 0x33) << 2;
+        return (bits & 0xAA) >> 1 | (bits & 0x55) << 1;
+    }
+
+    int16_t pageEnd() const
+    {
+        return pageY + PAGE_HEIGHT < PANEL_HEIGHT ? pageY + PAGE_HEIGHT : PANEL_HEIGHT;
+    }
+
+    uint8_t dirtyBands[(MAX_BANDS + 7) / 8];
+    uint16_t fillColor;
+    int16_t pageY = 0;
+
+    // scratch space of ditherGradient, 2.4 KB that would otherwise be on the stack of the task that renders
+    DitherLevel ditherLevels[MAX_LENGTH];
+    DitherBytes ditherBytes[8][WIDTH_BYTES];
+
+    static int16_t clamp(int16_t value, int16_t size)
+    {
+        return value < 0 ? 0 : value >= size ? size - 1 : value;
+    }
+};
+
+// these overloads are picked over the ones in dither.h if the canvas type is known
+
+template <int16_t W, int16_t H, int16_t P, size_t N>
+void drawRect(Canvas3C<W, H, P>& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t color)
+{
+    canvas.ditherGradient(pos, dim, palette, color, color, false);
+}
+
+template <int16_t W, int16_t H, int16_t P, size_t N>
+void drawGradientX(Canvas3C<W, H, P>& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2)
+{
+    canvas.ditherGradient(pos, dim, palette, c1, c2, false);
+}
+
+template <int16_t W, int16_t H, int16_t P, size_t N>
+void drawGradientY(Canvas3C<W, H, P>& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2)
+{
+    canvas.ditherGradient(pos, dim, palette, c1, c2, true);
+}
+
+template <int16_t W, int16_t H, int16_t P, size_t N>
+void drawFadeY(Canvas3C<W, H, P>& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2)
+{
+    canvas.ditherGradient(pos, dim, palette, c1, c2, true, true);
+}
+
+template <int16_t W, int16_t H, int16_t P, size_t N>
+void drawFadeY(Canvas3C<W, H, P>& canvas, xy_t pos, xy_t dim, xy_t clipPos, xy_t clipDim, const Palette<N>& palette, color_t c1, color_t c2)
+{
+    canvas.ditherGradient(pos, dim, clipPos, clipDim, palette, c1, c2, true, true);
+}
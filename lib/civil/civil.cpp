@@ -0,0 +1,69 @@
+#include "civil.h"
+
+static constexpr DstTable DST_TABLE = makeDstTable();
+
+static int32_t zoneOffset = 0;
+static int32_t zoneDstOffset = 0;
+
+void setTimeZone(int32_t offset, int32_t dstOffset)
+{
+    zoneOffset = offset;
+    zoneDstOffset = dstOffset;
+}
+
+static bool isDaylightSavingTime(int64_t time)
+{
+    int32_t year = civilFromDays(daysFromTime(time)).year;
+    uint8_t march, october;
+    if (year >= CIVIL_FIRST_YEAR && year <= CIVIL_LAST_YEAR) {
+        march = (DST_TABLE.days[year - CIVIL_FIRST_YEAR] & 0x0F) + 25;
+        october = (DST_TABLE.days[year - CIVIL_FIRST_YEAR] >> 4) + 25;
+    } else {
+        march = lastSunday(year, 3);
+        october = lastSunday(year, 10);
+    }
+
+    int64_t start = (int64_t)daysFromCivil(year, 3, march) * 86400 + 3600;
+    int64_t end = (int64_t)daysFromCivil(year, 10, october) * 86400 + 3600;
+    return time >= start && time < end;
+}
+
+int32_t localOffset(time_t time)
+{
+    return zoneDstOffset != 0 && isDaylightSavingTime(time) ? zoneOffset + zoneDstOffset : zoneOffset;
+}
+
+LocalTime toLocalTime(time_t time)
+{
+    int64_t local = (int64_t)time + localOffset(time);
+    int32_t days = daysFromTime(local);
+    int32_t seconds = local - (int64_t)days * 86400;
+    return {
+        days,
+        civilFromDays(days),
+        weekdayFromDays(days),
+        (uint8_t)(seconds / 3600),
+        (uint8_t)(seconds / 60 % 60),
+        (uint8_t)(seconds % 60),
+    };
+}
+
+int32_t localDays(time_t time)
+{
+    return daysFromTime((int64_t)time + localOffset(time));
+}
+
+time_t fromLocalTime(int32_t year, uint32_t month, uint32_t day, int32_t seconds)
+{
+    return fromLocalDays(daysFromCivil(year, month, day), seconds);
+}
+
+time_t fromLocalDays(int32_t days, int32_t seconds)
+{
+    int64_t time = (int64_t)days * 86400 + seconds - zoneOffset;
+    if (zoneDstOffset != 0 && isDaylightSavingTime(time - zoneDstOffset)) {
+        time -= zoneDstOffset;
+    }
+
+    return time;
+}
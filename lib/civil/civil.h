@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// https://howardhinnant.github.io/date_algorithms.html
+// exact gregorian rules for any year, without loops and without tables
+
+struct CivilDate {
+    int16_t year;
+    uint8_t month; // 1 - 12
+    uint8_t day; // 1 - 31
+};
+
+/**
+ * Returns the number of days since 1970-01-01 for the given date.
+ */
+constexpr int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day)
+{
+    year -= month <= 2;
+    int32_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t yearOfEra = year - era * 400;
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // starting in march
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+/**
+ * Returns the date of the given number of days since 1970-01-01.
+ */
+constexpr CivilDate civilFromDays(int32_t days)
+{
+    days += 719468;
+    int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    uint32_t dayOfEra = days - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100); // starting in march
+    uint32_t monthOfYear = (5 * dayOfYear + 2) / 153;
+    uint32_t month = monthOfYear < 10 ? monthOfYear + 3 : monthOfYear - 9;
+    return {
+        (int16_t)(yearOfEra + era * 400 + (month <= 2)),
+        (uint8_t)month,
+        (uint8_t)(dayOfYear - (153 * monthOfYear + 2) / 5 + 1),
+    };
+}
+
+/**
+ * Returns the week day of the given number of days since 1970-01-01, 0 is sunday like tm_wday.
+ */
+constexpr uint8_t weekdayFromDays(int32_t days)
+{
+    return days >= -4 ? (days + 4) % 7 : (days + 5) % 7 + 6;
+}
+
+/**
+ * Floors the division, so times before 1970 still end up on the right day.
+ */
+constexpr int32_t daysFromTime(int64_t time)
+{
+    return (int32_t)((time >= 0 ? time : time - 86399) / 86400);
+}
+
+/**
+ * The day of the last sunday of a month with 31 days, like march and october.
+ */
+constexpr uint8_t lastSunday(int32_t year, uint32_t month)
+{
+    return 31 - weekdayFromDays(daysFromCivil(year, month, 31));
+}
+
+// the years with a precomputed daylight saving time table, other years are calculated on demand
+#define CIVIL_FIRST_YEAR 1970
+#define CIVIL_LAST_YEAR 2200
+
+/**
+ * The days of the daylight saving time transitions (european rules),
+ * one byte per year with the last sunday of march (low nibble) and october (high nibble), both minus 25.
+ */
+struct DstTable {
+    uint8_t days[CIVIL_LAST_YEAR - CIVIL_FIRST_YEAR + 1];
+};
+
+constexpr DstTable makeDstTable()
+{
+    DstTable table = {};
+    for (int32_t year = CIVIL_FIRST_YEAR; year <= CIVIL_LAST_YEAR; ++year) {
+        table.days[year - CIVIL_FIRST_YEAR] = (lastSunday(year, 3) - 25) | (lastSunday(year, 10) - 25) << 4;
+    }
+
+    return table;
+}
+
+struct LocalTime {
+    int32_t days; // since 1970-01-01 in local time, replaces calculateDaystamp
+    CivilDate date;
+    uint8_t weekday; // 0 is sunday
+    uint8_t hour;
+    uint8_t minute;
+    uint8_t second;
+};
+
+/**
+ * Sets the time zone for all local time conversions.
+ * Daylight saving time follows the european rules:
+ * It starts at 01:00 UTC on the last sunday of march and ends at 01:00 UTC on the last sunday of october.
+ */
+void setTimeZone(int32_t offset, int32_t dstOffset);
+
+/**
+ * Returns the offset of local time to UTC at the given time.
+ */
+int32_t localOffset(time_t time);
+
+/**
+ * The replacement for localtime_r.
+ */
+LocalTime toLocalTime(time_t time);
+
+/**
+ * Returns the number of days since 1970-01-01 in local time.
+ */
+int32_t localDays(time_t time);
+
+/**
+ * The replacement for mktime.
+ * The hour that is skipped when daylight saving time starts is read as standard time,
+ * the hour that is repeated when it ends is read as daylight saving time.
+ */
+time_t fromLocalTime(int32_t year, uint32_t month, uint32_t day, int32_t seconds = 0);
+
+/**
+ * Same as fromLocalTime but with the date as days since 1970-01-01.
+ */
+time_t fromLocalDays(int32_t days, int32_t seconds = 0);
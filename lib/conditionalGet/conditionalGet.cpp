@@ -0,0 +1,91 @@
+#include "conditionalGet.h"
+
+#include <stdio.h>
+
+static const int STATUS_OK = 200;
+static const int STATUS_NOT_MODIFIED = 304;
+
+static void forget(HttpValidators& validators)
+{
+    validators.eTag[0] = '\0';
+    validators.lastModified[0] = '\0';
+}
+
+int conditionalGet(CachedResource& resource, HttpValidators& validators)
+{
+    bool conditional = validators.eTag[0] != '\0' || validators.lastModified[0] != '\0';
+    while (true) {
+        int status = resource.request(conditional && validators.eTag[0] != '\0' ? validators.eTag : nullptr,
+            conditional && validators.lastModified[0] != '\0' ? validators.lastModified : nullptr);
+
+        // an unconditional request can't be answered with a 304, a server that does so anyway must not be asked forever
+        if (status == STATUS_NOT_MODIFIED && conditional) {
+            bool cached = resource.loadCached();
+            resource.finish();
+            if (cached) {
+                return status;
+            }
+
+            conditional = false;
+            continue;
+        } else if (status != STATUS_OK) {
+            resource.finish();
+            return status;
+        }
+
+        forget(validators);
+        if (!resource.readBody(validators)) {
+            forget(validators);
+        }
+        resource.finish();
+        return status;
+    }
+}
+
+HttpResource::HttpResource(const char* url, bool acceptGzip)
+    : url(url)
+    , acceptGzip(acceptGzip)
+{
+}
+
+int HttpResource::request(const char* ifNoneMatch, const char* ifModifiedSince)
+{
+    http.begin(url);
+    // http 1.0 replaces the default Accept-Encoding header and the body is never chunked
+    http.useHTTP10(true);
+    // only these headers are kept by HTTPClient, all others are dropped while reading the response
+    const char* headerKeys[] = { "ETag", "Last-Modified", "Content-Encoding", "Date" };
+    http.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
+    if (acceptGzip) {
+        http.addHeader("Accept-Encoding", "gzip");
+    }
+    if (ifNoneMatch != nullptr) {
+        http.addHeader("If-None-Match", ifNoneMatch);
+    }
+    if (ifModifiedSince != nullptr) {
+        http.addHeader("If-Modified-Since", ifModifiedSince);
+    }
+
+    return http.GET();
+}
+
+void HttpResource::finish()
+{
+    http.end();
+}
+
+String HttpResource::date()
+{
+    return http.header("Date");
+}
+
+bool HttpResource::isGzip()
+{
+    return acceptGzip && http.header("Content-Encoding") == "gzip";
+}
+
+void HttpResource::keepValidators(HttpValidators& validators)
+{
+    snprintf(validators.eTag, sizeof(validators.eTag), "%s", http.header("ETag").c_str());
+    snprintf(validators.lastModified, sizeof(validators.lastModified), "%s", http.header("Last-Modified").c_str());
+}
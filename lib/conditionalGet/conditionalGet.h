@@ -0,0 +1,83 @@
+#pragma once
+
+#include <HTTPClient.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The ETag and Last-Modified headers of the last complete download, kept in RTC memory with the cached copy.
+ * An empty string means the header isn't known.
+ */
+struct HttpValidators {
+    char eTag[64];
+    char lastModified[32];
+};
+
+/**
+ * The parts of the http client and the cache a conditional download needs, so the decisions can be run against a fake server on the host.
+ */
+class CachedResource {
+public:
+    virtual ~CachedResource() = default;
+
+    /**
+     * Sends a GET with the given If-None-Match and If-Modified-Since headers, nullptr ones aren't sent.
+     * Returns the http status, 0 or less if there is no usable response. The response stays open until finish.
+     */
+    virtual int request(const char* ifNoneMatch, const char* ifModifiedSince) = 0;
+
+    /**
+     * Loads the cached copy after a 304 and returns if enough of it is left to be used.
+     */
+    virtual bool loadCached() = 0;
+
+    /**
+     * Reads the body of a 200 response and returns if it was read completely.
+     * Only then the validators of the response are written into validators.
+     */
+    virtual bool readBody(HttpValidators& validators) = 0;
+
+    /**
+     * Ends the current response.
+     */
+    virtual void finish() = 0;
+};
+
+/**
+ * A resource that is downloaded with HTTPClient, what to do with the body and the cached copy is up to the subclass.
+ */
+class HttpResource : public CachedResource {
+public:
+    /**
+     * Asks for a gzip body if acceptGzip, the response can still be uncompressed, see isGzip.
+     */
+    explicit HttpResource(const char* url, bool acceptGzip = false);
+
+    int request(const char* ifNoneMatch, const char* ifModifiedSince) override;
+    void finish() override;
+
+protected:
+    /**
+     * The time of the server, every response has one, a 304 as well. Empty if there is none.
+     */
+    String date();
+
+    bool isGzip();
+
+    /**
+     * Copies the ETag and Last-Modified of the response, empty ones if the server didn't send them.
+     */
+    void keepValidators(HttpValidators& validators);
+
+    HTTPClient http;
+    const char* url;
+    bool acceptGzip;
+};
+
+/**
+ * Downloads a resource that isn't downloaded again as long as the server says it isn't modified.
+ * The first request sends the validators, if the cached copy turns out to be too short it is requested again without them.
+ * The validators are forgotten while a new body is read, so a download that breaks off is never reused as the cached copy.
+ * Returns the status of the last response.
+ */
+int conditionalGet(CachedResource& resource, HttpValidators& validators);
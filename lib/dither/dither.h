@@ -3,9 +3,70 @@
 #include <Adafruit_GFX.h>
 #include <stdint.h>
 
+#define EXT_RED(color) (((color) >> 10) & 0b111110)
+#define EXT_GREEN(color) (((color) >> 5) & 0b111111)
+#define EXT_BLUE(color) (((color) << 1) & 0b111110)
+
+#define PACK_RED(color) (((color)&0b111110) << 10)
+#define PACK_GREEN(color) (((color)&0b111111) << 5)
+#define PACK_BLUE(color) (((color)&0b111110) >> 1)
+
+// https://en.wikipedia.org/wiki/Ordered_dithering
+#define DITHER_MAX 63
+static constexpr int8_t DITHER_PATTERN[8][8] = {
+    { 0, 48, 12, 60, 3, 51, 15, 63 },
+    { 32, 16, 44, 28, 35, 19, 47, 31 },
+    { 8, 56, 4, 52, 11, 59, 7, 55 },
+    { 40, 24, 36, 20, 43, 27, 39, 23 },
+    { 2, 50, 14, 62, 1, 49, 13, 61 },
+    { 34, 18, 46, 30, 33, 17, 45, 29 },
+    { 10, 58, 6, 54, 9, 57, 5, 53 },
+    { 42, 26, 38, 22, 41, 25, 37, 21 },
+};
+
 typedef uint16_t color_t;
-static const color_t COLORSPACE_2C[] = { 0x0000, 0xFFFF };
-static const color_t COLORSPACE_3C[] = { 0x0000, 0xF800, 0xFFFF };
+
+constexpr uint16_t brightness(color_t color)
+{
+    return EXT_RED(color) * 3 + EXT_GREEN(color) * 6 + EXT_BLUE(color);
+}
+
+/**
+ * A palette with everything the dither function needs precomputed.
+ * Create it with makePalette so the colors are sorted by brightness at compile time.
+ */
+template <size_t N>
+struct Palette {
+    color_t colors[N];
+    uint16_t brightness[N];
+    uint32_t reciprocal[N]; // DITHER_MAX divided by the distance to the next color as 12.20 fixed point
+};
+
+template <size_t N>
+constexpr Palette<N> makePalette(const color_t (&colors)[N])
+{
+    Palette<N> palette = {};
+    for (size_t i = 0; i < N; ++i) {
+        size_t j = i;
+        for (; j > 0 && palette.brightness[j - 1] > brightness(colors[i]); --j) {
+            palette.colors[j] = palette.colors[j - 1];
+            palette.brightness[j] = palette.brightness[j - 1];
+        }
+        palette.colors[j] = colors[i];
+        palette.brightness[j] = brightness(colors[i]);
+    }
+
+    // rounded up so the multiplication gives the same result as the division
+    for (size_t i = 0; i + 1 < N; ++i) {
+        uint32_t distance = palette.brightness[i + 1] - palette.brightness[i];
+        palette.reciprocal[i] = distance > 0 ? ((DITHER_MAX << 20) + distance - 1) / distance : 0;
+    }
+
+    return palette;
+}
+
+static constexpr Palette<2> COLORSPACE_2C = makePalette<2>({ 0x0000, 0xFFFF });
+static constexpr Palette<3> COLORSPACE_3C = makePalette<3>({ 0x0000, 0xF800, 0xFFFF });
 
 struct xy_t {
     int16_t x;
@@ -33,14 +94,87 @@ struct xy_t {
  * The ratio is from 0 - 256 where 0 is exactly c1 and 256 is exactly c2.
  * However, the max ratio you can provide is 255 so your logic must handle this case.
  */
-color_t mix(color_t c1, color_t c2, uint8_t ratio);
+constexpr color_t mix(color_t c1, color_t c2, uint8_t ratio)
+{
+    return PACK_RED((EXT_RED(c1) * (256 - ratio) + EXT_RED(c2) * ratio) / 256)
+        | PACK_GREEN((EXT_GREEN(c1) * (256 - ratio) + EXT_GREEN(c2) * ratio) / 256)
+        | PACK_BLUE((EXT_BLUE(c1) * (256 - ratio) + EXT_BLUE(c2) * ratio) / 256);
+}
+
+/**
+ * The result of dithering a color without the position:
+ * A pixel gets the low color if its pattern value is greater than the threshold, otherwise the high color.
+ * Colors are indexes into the palette and the threshold is -1 if the color is in the palette.
+ */
+struct DitherLevel {
+    uint8_t low;
+    uint8_t high;
+    int8_t threshold;
+};
+
+template <size_t N>
+constexpr DitherLevel ditherLevel(const Palette<N>& palette, color_t color)
+{
+    uint16_t colorBrightness = brightness(color);
+    if (colorBrightness <= palette.brightness[0]) {
+        return { 0, 0, -1 };
+    }
+
+    size_t i = 0;
+    while (i + 1 < N && palette.brightness[i + 1] <= colorBrightness) {
+        ++i;
+    }
+
+    if (palette.brightness[i] == colorBrightness || i + 1 == N) {
+        return { (uint8_t)i, (uint8_t)i, -1 };
+    }
+
+    int8_t threshold = (colorBrightness - palette.brightness[i]) * palette.reciprocal[i] >> 20;
+    return { (uint8_t)i, (uint8_t)(i + 1), threshold };
+}
 
 /**
  * This function handles pattern dithering.
  * Just provide a color and a palette and it'll give you a color for that particular pixel.
  * You have to call if for each pixel for best results.
+ *
+ * This algorythm is not great at all since it only respects brightness
+ * but all other algorythms are overkill for 3 colors.
  */
-color_t dither(xy_t pos, const color_t* palette, color_t color);
+template <size_t N>
+inline color_t dither(xy_t pos, const Palette<N>& palette, color_t color)
+{
+    auto level = ditherLevel(palette, color);
+    return DITHER_PATTERN[pos.x % 8][pos.y % 8] > level.threshold ? palette.colors[level.low] : palette.colors[level.high];
+}
+
+/**
+ * Bitmasks of the dither pattern for 8 adjacent pixels.
+ * rows[x % 8][threshold] has the bit of pixel y % 8 set (most significant bit first) if it gets the low color.
+ * columns[y % 8][threshold] is the same for 8 pixels along x.
+ * This allows dithering a whole byte of a frame buffer at once if the color is the same for those 8 pixels.
+ */
+struct DitherMasks {
+    uint8_t rows[8][DITHER_MAX + 1];
+    uint8_t columns[8][DITHER_MAX + 1];
+};
+
+constexpr DitherMasks makeDitherMasks()
+{
+    DitherMasks masks = {};
+    for (int8_t line = 0; line < 8; ++line) {
+        for (int8_t threshold = 0; threshold <= DITHER_MAX; ++threshold) {
+            for (int8_t i = 0; i < 8; ++i) {
+                masks.rows[line][threshold] |= (DITHER_PATTERN[line][i] > threshold) << (7 - i);
+                masks.columns[line][threshold] |= (DITHER_PATTERN[i][line] > threshold) << (7 - i);
+            }
+        }
+    }
+
+    return masks;
+}
+
+static constexpr DitherMasks DITHER_MASKS = makeDitherMasks();
 
 /**
  * This utility allows you to easily loop over a rectangle.
@@ -57,6 +191,22 @@ void inline loopRect(xy_t pos, xy_t size, F func)
     }
 }
 
-void drawRect(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const color_t* palette, color_t color);
-void drawGradientX(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const color_t* palette, color_t c1, color_t c2);
-void drawGradientY(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const color_t* palette, color_t c1, color_t c2);
\ No newline at end of file
+template <size_t N>
+void drawRect(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t color);
+template <size_t N>
+void drawGradientX(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2);
+template <size_t N>
+void drawGradientY(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2);
+
+/**
+ * Draws a vertical gradient from c1 to c2 but leaves all pixels untouched that would get c1,
+ * so the existing content fades into c2.
+ */
+template <size_t N>
+void drawFadeY(Adafruit_GFX& canvas, xy_t pos, xy_t dim, const Palette<N>& palette, color_t c1, color_t c2);
+
+/**
+ * Like drawFadeY but only the part of the fade within the clip rectangle is drawn.
+ */
+template <size_t N>
+void drawFadeY(Adafruit_GFX& canvas, xy_t pos, xy_t dim, xy_t clipPos, xy_t clipDim, const Palette<N>& palette, color_t c1, color_t c2);
\ No newline at end of file
@@ -1,112 +1,746 @@
 #include <time.h>
 #include <Stream.h>
-#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string.h>
+#include "civil.h"
 #include "iCal.h"
+#include "topList.h"
 
-template <typename T>
-size_t addToSortedList(T* list, size_t& listSize, const size_t& maxListSize, const T& item, bool (*isGreaterThan)(const T&, const T&))
+static bool isLaterEntry(const ICalEntry& a, const ICalEntry& b)
 {
-    for (size_t i = 0; i < listSize; ++i) {
-        if (!isGreaterThan(list[i], item)) {
-            continue;
-        }
+    return a.day > b.day;
+}
 
-        if (listSize < maxListSize) {
-            listSize++;
-        }
+// the summaries of all calenders, the calenders are read in parallel so the pool is locked while adding
+static char summaryTexts[ICAL_MAX_SUMMARIES][ICAL_SUMMARY_SIZE];
+static uint32_t summaryHashes[ICAL_MAX_SUMMARIES];
+static uint8_t summaryCount = 0;
+static std::mutex summaryLock;
+
+// FNV-1a, so the text only has to be compared if the hash matches
+static uint32_t hashSummary(const char* text, size_t length)
+{
+    uint32_t hash = 2166136261;
+    for (size_t i = 0; i < length; ++i) {
+        hash = (hash ^ (uint8_t)text[i]) * 16777619;
+    }
 
-        // move all entries (except the last entry) one further
-        // if the listSize was increased beforehand, then _all_ existing entries are moved by 1
-        // itemsToMove can be 0 if we replace the last value in list
-        size_t itemsToMove = listSize - i - 1;
-        memmove(&list[i + 1], &list[i], itemsToMove * sizeof(T));
+    return hash;
+}
 
-        // now copy the actual value in it's proper place
-        memcpy(&list[i], &item, sizeof(T));
-        return i;
+uint8_t internICalSummary(const char* text, size_t length)
+{
+    if (length >= ICAL_SUMMARY_SIZE) {
+        length = ICAL_SUMMARY_SIZE - 1;
     }
 
-    // if the above loop didn't add the item (and returned),
-    // then append the item to the list if there is still space
-    if (listSize < maxListSize) {
-        memcpy(&list[listSize], &item, sizeof(T));
-        return listSize++;
+    uint32_t hash = hashSummary(text, length);
+    std::lock_guard<std::mutex> lock(summaryLock);
+    for (uint8_t id = 0; id < summaryCount; ++id) {
+        if (summaryHashes[id] == hash && strncmp(summaryTexts[id], text, length) == 0 && summaryTexts[id][length] == '\0') {
+            return id;
+        }
     }
 
-    return maxListSize; // this is the position the item would have gotten if it were added
+    if (summaryCount == ICAL_MAX_SUMMARIES) {
+        return ICAL_NO_SUMMARY;
+    }
+
+    memcpy(summaryTexts[summaryCount], text, length);
+    summaryTexts[summaryCount][length] = '\0';
+    summaryHashes[summaryCount] = hash;
+    return summaryCount++;
+}
+
+const char* icalSummary(uint8_t id)
+{
+    return id < ICAL_MAX_SUMMARIES ? summaryTexts[id] : "";
+}
+
+enum Property : uint8_t {
+    PROPERTY_BEGIN,
+    PROPERTY_END,
+    PROPERTY_SUMMARY,
+    PROPERTY_DTSTART,
+    PROPERTY_RRULE,
+    PROPERTY_EXDATE,
+    PROPERTY_UNKNOWN,
+};
+static const char* const PROPERTY_NAMES[] = { "BEGIN", "END", "SUMMARY", "DTSTART", "RRULE", "EXDATE" };
+
+enum Component : uint8_t {
+    COMPONENT_VEVENT,
+    COMPONENT_VCALENDAR,
+    COMPONENT_UNKNOWN,
+};
+static const char* const COMPONENT_NAMES[] = { "VEVENT", "VCALENDAR" };
+
+enum RulePart : uint8_t {
+    RULE_FREQ,
+    RULE_INTERVAL,
+    RULE_COUNT,
+    RULE_UNTIL,
+    RULE_BYDAY,
+    RULE_UNKNOWN,
 };
+static const char* const RULE_PART_NAMES[] = { "FREQ", "INTERVAL", "COUNT", "UNTIL", "BYDAY" };
 
-ICalResult readICalEntry(Stream* stream, ICalEntry* target)
+// in the order of ICalFrequency, starting with ICAL_DAILY
+static const char* const FREQUENCY_NAMES[] = { "DAILY", "WEEKLY", "MONTHLY", "YEARLY" };
+
+// in the order of tm_wday
+static const char* const WEEKDAY_NAMES[] = { "SU", "MO", "TU", "WE", "TH", "FR", "SA" };
+
+static const ICalRecurrence NO_RECURRENCE = { ICAL_ONCE, 1, 0, {}, 0, 0, INT32_MAX, 0, {} };
+
+/**
+ * Removes all names from the candidates bitmask that don't have the given character at the given index.
+ * This allows matching names without buffering them.
+ */
+template <size_t N>
+uint8_t matchCandidates(uint8_t candidates, const char* const (&names)[N], uint8_t index, char c)
 {
-    bool inCalenderEntry = false;
-    char line[128];
-    tm time;
+    if (c >= 'a' && c <= 'z') {
+        c -= 'a' - 'A'; // names are case insensitive
+    }
 
-    bool hasSummary = false;
-    bool hasDate = false;
+    for (size_t i = 0; i < N; ++i) {
+        if (candidates & (1 << i) && (c == '\0' || names[i][index] != c)) {
+            candidates &= ~(1 << i);
+        }
+    }
 
-    while (auto lineLength = stream->readBytesUntil('\n', line, sizeof(line) - 1)) {
-        line[lineLength] = '\0'; // ensure the 0 byte is there
-        if (lineLength == 0) {
+    return candidates;
+}
+
+/**
+ * Returns the index of the name that was matched completely or N if there is none.
+ */
+template <size_t N>
+uint8_t resolveCandidates(uint8_t candidates, const char* const (&names)[N], uint8_t length)
+{
+    for (size_t i = 0; i < N; ++i) {
+        if (candidates & (1 << i) && names[i][length] == '\0') {
+            return i;
+        }
+    }
+
+    return N;
+}
+
+ICalResult ICalParser::write(const char* data, size_t length, size_t& consumed)
+{
+    for (consumed = 0; consumed < length; ++consumed) {
+        char c = data[consumed];
+        if (c == '\r') {
             continue;
         }
 
-        if (!inCalenderEntry) {
-            if (strncmp(line, "END:VCALENDAR", 13) == 0) {
-                return ICAL_END;
+        // a line is only complete once the next line doesn't start with whitespace
+        if (lineEnded) {
+            lineEnded = false;
+            if (c == ' ' || c == '\t') {
+                continue;
+            }
+
+            // the current character is not consumed so it'll be passed in again
+            auto result = endLine();
+            if (result != ICAL_NEED_MORE) {
+                return result;
             }
+        }
+
+        if (c == '\n') {
+            lineEnded = true;
 
-            if (strncmp(line, "BEGIN:VEVENT", 12) == 0) {
-                inCalenderEntry = true;
+            // nothing follows the end of the calender, so don't wait for the next line
+            if (state == STATE_VALUE && property == PROPERTY_END && resolveCandidates(candidates, COMPONENT_NAMES, matchLength) == COMPONENT_VCALENDAR) {
+                lineEnded = false;
+                consumed++;
+                return endLine();
             }
 
             continue;
         }
 
-        if (sscanf(line, "SUMMARY:%20[^\r\n(]", target->summary)) {
-            hasSummary = true;
-            continue;
+        switch (state) {
+        case STATE_NAME:
+            if (c == ':' || c == ';') {
+                resolveProperty();
+                state = c == ':' ? STATE_VALUE : STATE_PARAMS;
+            } else if (candidates) {
+                candidates = matchCandidates(candidates, PROPERTY_NAMES, matchLength++, c);
+            }
+            break;
+
+        case STATE_PARAMS:
+            if (c == '"') {
+                state = STATE_PARAMS_QUOTED;
+            } else if (c == ':') {
+                state = STATE_VALUE;
+            }
+            break;
+
+        case STATE_PARAMS_QUOTED:
+            if (c == '"') {
+                state = STATE_PARAMS;
+            }
+            break;
+
+        case STATE_VALUE:
+            if (property == PROPERTY_BEGIN || property == PROPERTY_END) {
+                if (candidates) {
+                    candidates = matchCandidates(candidates, COMPONENT_NAMES, matchLength++, c);
+                }
+            } else if (!inEvent || nesting > 0) {
+                // summary and start of other components, like alarms, are ignored
+            } else if (property == PROPERTY_SUMMARY && !summaryDone) {
+                if (escaped) {
+                    escaped = false;
+                    if (c == 'n' || c == 'N') {
+                        c = ' ';
+                    }
+                } else if (c == '\\') {
+                    escaped = true;
+                    break;
+                } else if (c == '(') {
+                    summaryDone = true; // the feed puts the interval in braces which is not needed
+                    break;
+                }
+
+                if (summaryLength < sizeof(summary) - 1) {
+                    summary[summaryLength++] = c;
+                }
+            } else if (property == PROPERTY_RRULE) {
+                parseRule(c);
+            } else if (property == PROPERTY_EXDATE && c == ',') {
+                endExdate();
+            } else if ((property == PROPERTY_DTSTART || property == PROPERTY_EXDATE) && dateDigits < 8) {
+                // only the date part (YYYYMMDD) of the value is relevant
+                if (c >= '0' && c <= '9') {
+                    date = date * 10 + (c - '0');
+                    dateDigits++;
+                } else {
+                    dateDigits = UINT8_MAX;
+                }
+            }
+            break;
         }
+    }
 
-        if (sscanf(line, "DTSTART;VALUE=DATE:20%2d%2d%2d", &time.tm_year, &time.tm_mon, &time.tm_mday)) {
-            time.tm_year += 100;
-            time.tm_mon -= 1;
-            time.tm_hour = 0;
-            time.tm_min = 0;
-            time.tm_sec = 0;
-            time.tm_isdst = -1;
-            target->start = mktime(&time);
-            hasDate = true;
-            continue;
+    return ICAL_NEED_MORE;
+}
+
+uint8_t ICalParser::internSummary()
+{
+    if (current.summary == ICAL_NO_SUMMARY) {
+        current.summary = internICalSummary(summary, summaryLength);
+    }
+
+    return current.summary;
+}
+
+ICalResult ICalParser::finish()
+{
+    // the last line might not be terminated
+    lineEnded = false;
+    return endLine();
+}
+
+void ICalParser::resolveProperty()
+{
+    property = resolveCandidates(candidates, PROPERTY_NAMES, matchLength);
+    candidates = 0xFF;
+    matchLength = 0;
+
+    // the properties of nested components, like the SUMMARY of a VALARM, must not reset the ones of the event
+    if (!inEvent || nesting > 0) {
+        return;
+    }
+
+    if (property == PROPERTY_SUMMARY) {
+        summaryLength = 0;
+        summaryDone = false;
+        escaped = false;
+    } else if (property == PROPERTY_DTSTART || property == PROPERTY_EXDATE) {
+        date = 0;
+        dateDigits = 0;
+    } else if (property == PROPERTY_RRULE) {
+        inRuleValue = false;
+    }
+}
+
+/**
+ * The value of RRULE is a list of parts like FREQ=WEEKLY;INTERVAL=2;BYDAY=MO,TH
+ * which are matched the same way as the property names.
+ */
+void ICalParser::parseRule(char c)
+{
+    if (c == ';') {
+        endRulePart();
+        return;
+    }
+
+    if (!inRuleValue) {
+        if (c == '=') {
+            rulePart = resolveCandidates(candidates, RULE_PART_NAMES, matchLength);
+            inRuleValue = true;
+            candidates = 0xFF;
+            matchLength = 0;
+            date = 0;
+            dateDigits = 0;
+            sign = 1;
+        } else if (candidates) {
+            candidates = matchCandidates(candidates, RULE_PART_NAMES, matchLength++, c);
+        }
+        return;
+    }
+
+    if (rulePart == RULE_BYDAY && c == ',') {
+        endWeekday();
+    } else if (rulePart == RULE_BYDAY && c == '-') {
+        sign = -1;
+    } else if (c >= '0' && c <= '9') {
+        // numbers of INTERVAL, COUNT and the ordinal in BYDAY, only the date part of UNTIL is relevant
+        if (dateDigits < 8) {
+            date = date * 10 + (c - '0');
+            dateDigits++;
+        }
+    } else if (rulePart == RULE_FREQ && candidates) {
+        candidates = matchCandidates(candidates, FREQUENCY_NAMES, matchLength++, c);
+    } else if (rulePart == RULE_BYDAY && candidates) {
+        candidates = matchCandidates(candidates, WEEKDAY_NAMES, matchLength++, c);
+    }
+}
+
+void ICalParser::endRulePart()
+{
+    if (inRuleValue) {
+        switch (rulePart) {
+        case RULE_FREQ: {
+            auto frequency = resolveCandidates(candidates, FREQUENCY_NAMES, matchLength);
+            if (frequency < sizeof(FREQUENCY_NAMES) / sizeof(FREQUENCY_NAMES[0])) {
+                rule.frequency = (ICalFrequency)(ICAL_DAILY + frequency);
+            }
+            break;
+        }
+
+        case RULE_INTERVAL:
+            rule.interval = date > 0 && date <= UINT16_MAX ? date : 1;
+            break;
+
+        case RULE_COUNT:
+            rule.count = date <= UINT16_MAX ? date : UINT16_MAX;
+            break;
+
+        case RULE_UNTIL:
+            if (dateDigits == 8) {
+                rule.until = daysFromCivil(date / 10000, date / 100 % 100, date % 100);
+            }
+            break;
+
+        case RULE_BYDAY:
+            endWeekday();
+            break;
+        }
+    }
+
+    inRuleValue = false;
+    candidates = 0xFF;
+    matchLength = 0;
+}
+
+void ICalParser::endWeekday()
+{
+    auto weekday = resolveCandidates(candidates, WEEKDAY_NAMES, matchLength);
+    if (weekday < 7) {
+        rule.weekdays |= 1 << weekday;
+        // a month has at most 5 of every weekday, bit 15 never matches so a larger ordinal doesn't become every day
+        if (date > 0) {
+            rule.ordinals[weekday] |= date > 5 ? 1 << 15 : sign > 0 ? 1 << (date - 1) : 1 << (date + 4);
+        }
+    }
+
+    candidates = 0xFF;
+    matchLength = 0;
+    date = 0;
+    dateDigits = 0;
+    sign = 1;
+}
+
+void ICalParser::endExdate()
+{
+    if (dateDigits == 8 && rule.exdateCount < ICAL_MAX_EXDATES) {
+        rule.exdates[rule.exdateCount++] = daysFromCivil(date / 10000, date / 100 % 100, date % 100);
+    }
+
+    date = 0;
+    dateDigits = 0;
+}
+
+ICalResult ICalParser::endLine()
+{
+    ICalResult result = ICAL_NEED_MORE;
+    bool active = inEvent && nesting == 0;
+
+    if (state == STATE_VALUE) {
+        auto component = resolveCandidates(candidates, COMPONENT_NAMES, matchLength);
+        switch (property) {
+        case PROPERTY_BEGIN:
+            if (inEvent) {
+                nesting++;
+            } else if (component == COMPONENT_VEVENT) {
+                inEvent = true;
+                summaryLength = 0;
+                eventDate = 0;
+                rule = NO_RECURRENCE;
+            }
+            break;
+
+        case PROPERTY_END:
+            if (component == COMPONENT_VCALENDAR) {
+                inEvent = false;
+                result = ICAL_END;
+            } else if (inEvent && nesting > 0) {
+                nesting--;
+            } else if (inEvent && component == COMPONENT_VEVENT) {
+                inEvent = false;
+                if (summaryLength > 0 && eventDate > 0) {
+                    rule.start = daysFromCivil(eventDate / 10000, eventDate / 100 % 100, eventDate % 100);
+                    current.day = rule.start;
+                    current.summary = ICAL_NO_SUMMARY;
+                    result = ICAL_OK;
+                }
+            }
+            break;
+
+        case PROPERTY_SUMMARY:
+            if (active) {
+                while (summaryLength > 0 && summary[summaryLength - 1] == ' ') {
+                    summaryLength--;
+                }
+            }
+            break;
+
+        case PROPERTY_DTSTART:
+            if (active && dateDigits == 8) {
+                eventDate = date;
+            }
+            break;
+
+        case PROPERTY_RRULE:
+            if (active) {
+                endRulePart();
+            }
+            break;
+
+        case PROPERTY_EXDATE:
+            if (active) {
+                endExdate();
+            }
+            break;
         }
+    }
+
+    state = STATE_NAME;
+    property = PROPERTY_UNKNOWN;
+    candidates = 0xFF;
+    matchLength = 0;
+    return result;
+}
+
+// weeks start on monday, like the default WKST
+static int32_t startOfWeek(int32_t day)
+{
+    return day - (weekdayFromDays(day) + 6) % 7;
+}
+
+static int32_t monthIndex(int32_t day)
+{
+    auto date = civilFromDays(day);
+    return date.year * 12 + date.month - 1;
+}
+
+static uint8_t countBits(uint32_t bits)
+{
+    uint8_t count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+
+    return count;
+}
+
+ICalOccurrences::ICalOccurrences(const ICalRecurrence& rule, int32_t from)
+    : rule(rule)
+    , from(from)
+    , frequency(rule.frequency)
+    , interval(rule.interval > 0 ? rule.interval : 1)
+    , count(rule.count)
+    , weekdays(rule.weekdays)
+{
+    if (frequency == ICAL_ONCE) {
+        frequency = ICAL_DAILY;
+        count = 1;
+        weekdays = 0;
+    }
 
-        if (strncmp(line, "END:VEVENT", 10) == 0) {
-            if (hasSummary && hasDate) {
-                return ICAL_OK;
+    loadPeriod();
+    if (from <= rule.start) {
+        return;
+    }
+
+    // jump to the period that contains from, the occurrences that were skipped still count towards COUNT
+    switch (frequency) {
+    case ICAL_DAILY:
+        period = (from - rule.start) / interval;
+        if (weekdays) {
+            // the week days of the periods repeat every 7 periods
+            for (int32_t i = 0; i < 7 && i < period; ++i) {
+                if (weekdays & 1 << weekdayFromDays(rule.start + i * interval)) {
+                    emitted += (period - i + 6) / 7;
+                }
+            }
+        } else {
+            emitted = period;
+        }
+        break;
+
+    case ICAL_WEEKLY:
+        period = (startOfWeek(from) - startOfWeek(rule.start)) / 7 / interval;
+        emitted = period > 0 ? countBits(days) + (period - 1) * countBits(weekdays ? weekdays : 1) : 0;
+        break;
+
+    case ICAL_MONTHLY:
+        // the number of occurrences per month varies, so with a COUNT they have to be counted one by one
+        period = count ? 0 : (monthIndex(from) - monthIndex(rule.start)) / interval;
+        break;
+
+    case ICAL_YEARLY:
+        period = count ? 0 : (civilFromDays(from).year - civilFromDays(rule.start).year) / interval;
+        break;
+
+    default:
+        break;
+    }
+
+    loadPeriod();
+}
+
+void ICalOccurrences::loadPeriod()
+{
+    auto start = civilFromDays(rule.start);
+    days = 0;
+
+    switch (frequency) {
+    case ICAL_DAILY:
+        periodStart = rule.start + period * interval;
+        if (!weekdays || weekdays & 1 << weekdayFromDays(periodStart)) {
+            days = 1;
+        }
+        break;
+
+    case ICAL_WEEKLY: {
+        periodStart = startOfWeek(rule.start) + period * interval * 7;
+        uint8_t mask = weekdays ? weekdays : 1 << weekdayFromDays(rule.start);
+        for (uint8_t i = 0; i < 7; ++i) {
+            if (mask & 1 << (i + 1) % 7) {
+                days |= 1 << i;
             }
+        }
+        break;
+    }
+
+    case ICAL_MONTHLY: {
+        int32_t month = start.year * 12 + start.month - 1 + period * interval;
+        periodStart = daysFromCivil(month / 12, month % 12 + 1, 1);
+        int32_t length = daysFromCivil((month + 1) / 12, (month + 1) % 12 + 1, 1) - periodStart;
+        if (!weekdays) {
+            days = start.day <= length ? 1 << (start.day - 1) : 0;
+            break;
+        }
+
+        // BYDAY=2TU only keeps the second tuesday of the month, -1 the last one
+        int32_t first = weekdayFromDays(periodStart);
+        for (int32_t weekday = 0; weekday < 7; ++weekday) {
+            if (!(weekdays & 1 << weekday)) {
+                continue;
+            }
+
+            int32_t offset = (weekday - first + 7) % 7;
+            int32_t matches = (length - 1 - offset) / 7 + 1;
+            uint16_t ordinals = rule.ordinals[weekday];
+            for (int32_t n = 1; n <= matches; ++n) {
+                if (!ordinals || ordinals & 1 << (n - 1)) {
+                    days |= 1 << (offset + (n - 1) * 7);
+                }
+                if (ordinals & 1 << (n + 4)) {
+                    days |= 1 << (offset + (matches - n) * 7);
+                }
+            }
+        }
+        break;
+    }
 
-            hasSummary = false;
-            hasDate = false;
+    case ICAL_YEARLY: {
+        int32_t year = start.year + period * interval;
+        periodStart = daysFromCivil(year, start.month, 1);
+        int32_t length = daysFromCivil(year + (start.month == 12), start.month % 12 + 1, 1) - periodStart;
+        days = start.day <= length ? 1 << (start.day - 1) : 0;
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    // the first period can start before the event itself
+    if (periodStart < rule.start) {
+        days &= UINT32_MAX << (rule.start - periodStart);
+    }
+}
+
+bool ICalOccurrences::isExcluded(int32_t day) const
+{
+    for (uint8_t i = 0; i < rule.exdateCount; ++i) {
+        if (rule.exdates[i] == day) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ICalOccurrences::next(int32_t& day)
+{
+    while (count == 0 || emitted < count) {
+        if (days == 0) {
+            // a rule that never matches, like the 31st of every other month in a short month, must not loop forever
+            if (periodStart > rule.until || ++emptyPeriods > 1000) {
+                return false;
+            }
+
+            period++;
+            loadPeriod();
             continue;
         }
-    };
 
-    return ICAL_END_UNEXPECRED;
+        int32_t candidate = periodStart + countBits((days & -days) - 1);
+        days &= days - 1;
+        emptyPeriods = 0;
+        if (candidate > rule.until) {
+            return false;
+        }
+
+        emitted++;
+        if (candidate >= from && !isExcluded(candidate)) {
+            day = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Adds the occurrences of the last parsed entry that are at or after startTime.
+ * This stops as soon as an occurrence doesn't make it into the list since all following ones are even later.
+ */
+static void addOccurrences(TopList<ICalEntry, isLaterEntry>& entries, ICalParser& parser, int32_t firstDay, uint8_t source)
+{
+    ICalEntry entry = parser.entry();
+    entry.source = source;
+    ICalOccurrences occurrences(parser.recurrence(), firstDay);
+    while (occurrences.next(entry.day)) {
+        if (entries.rejects(entry)) {
+            break;
+        }
+
+        if (entry.summary == ICAL_NO_SUMMARY) {
+            entry.summary = parser.internSummary();
+        }
+        entries.add(entry);
+    }
+}
+
+ICalResult readICalStream(Stream* stream, ICalEntry* list, size_t& listSize, size_t maxSize, int32_t firstDay, uint8_t source)
+{
+    // entries on the same day stay in the order of the feed
+    std::unique_ptr<uint32_t[]> order(new (std::nothrow) uint32_t[maxSize > 0 ? maxSize : 1]);
+    if (!order) {
+        return ICAL_END_UNEXPECRED;
+    }
+
+    TopList<ICalEntry, isLaterEntry> entries(list, order.get(), maxSize, listSize);
+    ICalParser parser;
+    char buffer[256];
+
+    auto result = ICAL_NEED_MORE;
+    while (result == ICAL_NEED_MORE) {
+        // read whatever already arrived and only block for a single byte if nothing is there
+        int available = stream->available();
+        size_t length = stream->readBytes(buffer, available > (int)sizeof(buffer) ? sizeof(buffer) : available > 0 ? available : 1);
+
+        size_t offset = 0;
+        do {
+            size_t consumed = 0;
+            result = length > 0
+                ? parser.write(buffer + offset, length - offset, consumed)
+                : parser.finish();
+            offset += consumed;
+
+            if (result == ICAL_OK) {
+                addOccurrences(entries, parser, firstDay, source);
+                result = ICAL_NEED_MORE;
+            }
+        } while (result == ICAL_NEED_MORE && offset < length);
+
+        if (length == 0 && result == ICAL_NEED_MORE) {
+            result = ICAL_END_UNEXPECRED;
+        }
+    }
+
+    listSize = entries.size();
+    entries.sort();
+    return result;
+}
+
+void dropICalEntriesBefore(ICalEntry* list, size_t& listSize, int32_t firstDay)
+{
+    size_t expired = 0;
+    while (expired < listSize && list[expired].day < firstDay) {
+        expired++;
+    }
+
+    memmove(list, list + expired, (listSize - expired) * sizeof(ICalEntry));
+    listSize -= expired;
 }
 
-ICalResult readICalStream(Stream* stream, ICalEntry* list, size_t& listSize, size_t maxSize, time_t startTime)
+size_t mergeICalEntries(const ICalEntry* const* lists, const size_t* listSizes, size_t listCount, ICalEntry* list, size_t maxSize)
 {
-    ICalEntry readEntry;
-    ICalResult lastResult;
-    
-    unsigned long count = 0;
-    while ((lastResult = readICalEntry(stream, &readEntry)) == ICAL_OK) {
-        if (readEntry.start >= startTime) {
-            addToSortedList<ICalEntry>(list, listSize, maxSize, readEntry, [](const ICalEntry& a, const ICalEntry& b) {
-                return a.start > b.start;
-            });
+    // there are only a few sources, so the next entry is found by looking at the head of every list
+    size_t positions[ICAL_MAX_SOURCES] = {};
+    if (listCount > ICAL_MAX_SOURCES) {
+        listCount = ICAL_MAX_SOURCES;
+    }
+
+    size_t size = 0;
+    while (size < maxSize) {
+        size_t next = listCount;
+        for (size_t i = 0; i < listCount; ++i) {
+            if (positions[i] < listSizes[i] && (next == listCount || lists[i][positions[i]].day < lists[next][positions[next]].day)) {
+                next = i;
+            }
         }
+
+        if (next == listCount) {
+            break;
+        }
+
+        list[size++] = lists[next][positions[next]++];
     }
 
-    return lastResult;
+    return size;
 }
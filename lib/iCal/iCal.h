@@ -1,21 +1,193 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
+class Stream;
+
+#define ICAL_SUMMARY_SIZE 20 // including the terminator, longer summaries are cut
+#define ICAL_MAX_SUMMARIES 64
+#define ICAL_NO_SUMMARY 0xFF
+
+/**
+ * An entry is just the day and the id of its summary,
+ * the feeds only have a handful of distinct summaries that are repeated all year.
+ */
 struct ICalEntry {
-    time_t start;
-    char summary[20];
+    int32_t day; // local days since 1970-01-01
+    uint8_t summary; // see icalSummary
+    uint8_t source; // which calender the entry came from
 };
 
+/**
+ * Returns the id of the given summary, which is added to the summary pool if it isn't in there yet.
+ * Returns ICAL_NO_SUMMARY if the pool is full. This can be called from any task.
+ */
+uint8_t internICalSummary(const char* text, size_t length);
+
+/**
+ * Returns the text of a summary id, an empty string for ICAL_NO_SUMMARY.
+ */
+const char* icalSummary(uint8_t id);
+
 enum ICalResult {
     ICAL_OK,
     ICAL_END,
     ICAL_END_UNEXPECRED,
+    ICAL_NEED_MORE,
+};
+
+enum ICalFrequency : uint8_t {
+    ICAL_ONCE,
+    ICAL_DAILY,
+    ICAL_WEEKLY,
+    ICAL_MONTHLY,
+    ICAL_YEARLY,
+};
+
+#define ICAL_MAX_EXDATES 8
+
+/**
+ * The RRULE and EXDATE properties of an event, all dates are days since 1970-01-01.
+ * Only the date part of the values is used since the calender only shows days.
+ */
+struct ICalRecurrence {
+    ICalFrequency frequency;
+    uint16_t interval;
+    uint8_t weekdays; // BYDAY as bitmask, bit 0 is sunday
+    uint16_t ordinals[7]; // per weekday the 2 in BYDAY=2TU as bit 1 and the -1 in BYDAY=-1FR as bit 5, 0 if every matching day
+    uint16_t count; // 0 if unlimited
+    int32_t start;
+    int32_t until;
+    uint8_t exdateCount; // excluded dates that didn't fit are ignored
+    int32_t exdates[ICAL_MAX_EXDATES];
+};
+
+/**
+ * Expands a recurrence lazily, starting at the given day.
+ * Periods before that day are skipped by calculation instead of iterating over them,
+ * except for monthly and yearly rules with a COUNT.
+ */
+class ICalOccurrences {
+public:
+    ICalOccurrences(const ICalRecurrence& rule, int32_t from);
+
+    /**
+     * Sets day to the next occurrence and returns false if there is none.
+     */
+    bool next(int32_t& day);
+
+private:
+    void loadPeriod();
+    bool isExcluded(int32_t day) const;
+
+    const ICalRecurrence& rule;
+    int32_t from;
+    ICalFrequency frequency;
+    uint16_t interval;
+    uint16_t count;
+    uint8_t weekdays;
+    int32_t period = 0;
+    int32_t periodStart = 0;
+    uint32_t days = 0; // bit i is set if periodStart + i is an occurrence
+    uint32_t emitted = 0; // occurrences since the start of the rule, excluded ones count as well
+    uint16_t emptyPeriods = 0;
+};
+
+/**
+ * A push parser for iCal data.
+ * It accepts the calender in chunks of any size, like they come from the network,
+ * and only understands the properties needed for the calender (BEGIN, END, SUMMARY, DTSTART, RRULE and EXDATE).
+ * Folded lines are unfolded on the fly and only the summary is copied out of the input.
+ */
+class ICalParser {
+public:
+    /**
+     * Parses the given chunk.
+     * Parsing stops once an entry is complete (ICAL_OK) or the calender ended (ICAL_END),
+     * consumed tells how many bytes were used so the rest can be passed in again.
+     * ICAL_NEED_MORE means the whole chunk was consumed.
+     */
+    ICalResult write(const char* data, size_t length, size_t& consumed);
+
+    /**
+     * Tells the parser that there is no more data.
+     * This completes the last line which may contain an entry (ICAL_OK) or the end of the calender (ICAL_END).
+     */
+    ICalResult finish();
+
+    /**
+     * The last completed entry, only valid after write or finish returned ICAL_OK.
+     * Its summary is ICAL_NO_SUMMARY until internSummary is called,
+     * so the summaries of entries that don't make it into the list don't fill the summary pool.
+     */
+    const ICalEntry& entry() const { return current; }
+
+    /**
+     * Adds the summary of the last completed entry to the summary pool and returns its id.
+     */
+    uint8_t internSummary();
+
+    /**
+     * The recurrence of the last completed entry, the frequency is ICAL_ONCE if it has none.
+     */
+    const ICalRecurrence& recurrence() const { return rule; }
+
+private:
+    enum State : uint8_t {
+        STATE_NAME,
+        STATE_PARAMS,
+        STATE_PARAMS_QUOTED,
+        STATE_VALUE,
+    };
+
+    ICalResult endLine();
+    void resolveProperty();
+    void parseRule(char c);
+    void endRulePart();
+    void endWeekday();
+    void endExdate();
+
+    ICalEntry current;
+    ICalRecurrence rule;
+    char summary[ICAL_SUMMARY_SIZE];
+    State state = STATE_NAME;
+    bool lineEnded = false;
+    bool inEvent = false;
+    bool escaped = false;
+    bool summaryDone = false;
+    uint8_t nesting = 0;
+    uint8_t property = 0;
+    uint8_t candidates = 0xFF;
+    uint8_t matchLength = 0;
+    uint8_t summaryLength = 0;
+    uint8_t dateDigits = 0;
+    uint32_t date = 0;
+    uint32_t eventDate = 0;
+    bool inRuleValue = false;
+    uint8_t rulePart = 0;
+    int8_t sign = 1;
 };
 
 /**
  * Reads all iCal entries from the given stream into the given array in ascending order.
- * All items before startTime are dropped.
+ * Recurring entries are expanded into their occurrences.
+ * All items before firstDay are dropped.
  * Items that don't fit in the list are dropped as well.
+ * All read entries are tagged with the given source.
+ */
+ICalResult readICalStream(Stream* stream, ICalEntry* list, size_t& listSize, size_t maxSize, int32_t firstDay, uint8_t source = 0);
+
+#define ICAL_MAX_SOURCES 8
+
+/**
+ * Merges the given ascending lists into one ascending list with up to maxSize entries.
+ * Returns the number of entries in the merged list, lists after ICAL_MAX_SOURCES are ignored.
+ */
+size_t mergeICalEntries(const ICalEntry* const* lists, const size_t* listSizes, size_t listCount, ICalEntry* list, size_t maxSize);
+
+/**
+ * Removes all entries before firstDay from the given ascending list.
  */
-ICalResult readICalStream(Stream* stream, ICalEntry* list, size_t& listSize, size_t maxSize, time_t startTime);
+void dropICalEntriesBefore(ICalEntry* list, size_t& listSize, int32_t firstDay);
@@ -0,0 +1,403 @@
+#include "inflate.h"
+
+#include <string.h>
+
+// the base values and extra bits of the length symbols 257 - 285 and the distance symbols 0 - 29
+static const uint16_t LENGTH_BASES[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DISTANCE_BASES[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// the order in which the code lengths of the code length code are stored
+static const uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+/**
+ * Builds the canonical code for the given code lengths.
+ * Returns false if the lengths describe more codes than there are bit patterns.
+ * Incomplete codes are accepted, a bit pattern without a code is detected when it shows up.
+ */
+static constexpr bool buildHuffman(InflateHuffman& huffman, const uint8_t* lengths, size_t count)
+{
+    for (auto& c : huffman.counts) {
+        c = 0;
+    }
+    for (size_t symbol = 0; symbol < count; ++symbol) {
+        huffman.counts[lengths[symbol]]++;
+    }
+
+    int32_t left = 1;
+    uint16_t offsets[16] = {};
+    for (size_t length = 1; length < 16; ++length) {
+        left = left * 2 - huffman.counts[length];
+        if (left < 0) {
+            return false;
+        }
+        if (length < 15) {
+            offsets[length + 1] = offsets[length] + huffman.counts[length];
+        }
+    }
+
+    for (size_t symbol = 0; symbol < count; ++symbol) {
+        if (lengths[symbol] != 0) {
+            huffman.symbols[offsets[lengths[symbol]]++] = symbol;
+        }
+    }
+
+    return true;
+}
+
+constexpr InflateHuffman makeFixedLengths()
+{
+    uint8_t lengths[288] = {};
+    for (size_t symbol = 0; symbol < 288; ++symbol) {
+        lengths[symbol] = symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8;
+    }
+
+    InflateHuffman huffman = {};
+    buildHuffman(huffman, lengths, 288);
+    return huffman;
+}
+
+constexpr InflateHuffman makeFixedDistances()
+{
+    uint8_t lengths[30] = {};
+    for (auto& length : lengths) {
+        length = 5;
+    }
+
+    InflateHuffman huffman = {};
+    buildHuffman(huffman, lengths, 30);
+    return huffman;
+}
+
+// the codes of blocks with fixed huffman codes, built at compile time so they end up in flash
+static constexpr InflateHuffman FIXED_LENGTHS = makeFixedLengths();
+static constexpr InflateHuffman FIXED_DISTANCES = makeFixedDistances();
+
+void InflateStream::begin(Stream* stream)
+{
+    this->stream = stream;
+    state = STATE_GZIP_HEADER;
+    lastBlock = false;
+    bitCount = 0;
+    bitBuffer = 0;
+    storedLeft = 0;
+    copyLength = 0;
+    peeked = -1;
+    inputSize = 0;
+    inputPosition = 0;
+    inputTotal = 0;
+    windowPosition = 0;
+}
+
+int InflateStream::nextByte()
+{
+    if (inputPosition == inputSize) {
+        // read whatever already arrived and only block for a single byte if nothing is there
+        int available = stream->available();
+        inputSize = stream->readBytes((char*)input, available > (int)sizeof(input) ? sizeof(input) : available > 0 ? available : 1);
+        inputPosition = 0;
+        inputTotal += inputSize;
+        if (inputSize == 0) {
+            state = STATE_ERROR;
+            return -1;
+        }
+    }
+
+    return input[inputPosition++];
+}
+
+/**
+ * Reads the given number of bits, least significant bit first.
+ * Returns 0 once the input ended, the state is STATE_ERROR then.
+ */
+uint32_t InflateStream::bits(uint8_t count)
+{
+    while (bitCount < count) {
+        int c = nextByte();
+        if (c < 0) {
+            return 0;
+        }
+        bitBuffer |= (uint32_t)c << bitCount;
+        bitCount += 8;
+    }
+
+    uint32_t value = bitBuffer & ((1u << count) - 1);
+    bitBuffer >>= count;
+    bitCount -= count;
+    return value;
+}
+
+/**
+ * Decodes the next symbol, huffman codes are stored most significant bit first.
+ * Returns -1 if the bits don't match any code.
+ */
+int InflateStream::decode(const InflateHuffman& huffman)
+{
+    int code = 0; // the bits read so far
+    int first = 0; // the first code of the current length
+    int index = 0; // the index of that code in symbols
+    for (size_t length = 1; length < 16; ++length) {
+        code |= bits(1);
+        int count = huffman.counts[length];
+        if (code - first < count) {
+            return huffman.symbols[index + code - first];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+void InflateStream::readGzipHeader()
+{
+    uint8_t header[10];
+    for (auto& c : header) {
+        c = nextByte();
+    }
+
+    uint8_t flags = header[3];
+    if (header[0] != 0x1F || header[1] != 0x8B || header[2] != 8 || (flags & 0xE0) != 0) {
+        state = STATE_ERROR;
+        return;
+    }
+
+    if (flags & 0x04) { // FEXTRA
+        uint16_t length = nextByte();
+        length |= nextByte() << 8;
+        while (length-- > 0 && state != STATE_ERROR) {
+            nextByte();
+        }
+    }
+    if (flags & 0x08) { // FNAME, zero terminated
+        while (nextByte() > 0) {
+        }
+    }
+    if (flags & 0x10) { // FCOMMENT, zero terminated
+        while (nextByte() > 0) {
+        }
+    }
+    if (flags & 0x02) { // FHCRC
+        nextByte();
+        nextByte();
+    }
+
+    if (state != STATE_ERROR) {
+        state = STATE_BLOCK_HEADER;
+    }
+}
+
+void InflateStream::readBlockHeader()
+{
+    if (lastBlock) {
+        state = STATE_END;
+        return;
+    }
+
+    lastBlock = bits(1);
+    uint32_t type = bits(2);
+    if (state == STATE_ERROR) {
+        return;
+    }
+
+    switch (type) {
+    case 0:
+        // stored blocks start at the next byte, the bit buffer never holds a whole byte here
+        bitBuffer = 0;
+        bitCount = 0;
+        storedLeft = bits(16);
+        if ((uint16_t)~storedLeft != bits(16) || state == STATE_ERROR) {
+            state = STATE_ERROR;
+            return;
+        }
+        state = STATE_STORED;
+        break;
+    case 1:
+        lengthCode = &FIXED_LENGTHS;
+        distanceCode = &FIXED_DISTANCES;
+        state = STATE_HUFFMAN;
+        break;
+    case 2:
+        readDynamicTables();
+        break;
+    default:
+        state = STATE_ERROR;
+        break;
+    }
+}
+
+void InflateStream::readDynamicTables()
+{
+    uint16_t lengthCount = bits(5) + 257;
+    uint8_t distanceCount = bits(5) + 1;
+    uint8_t codeLengthCount = bits(4) + 4;
+    if (lengthCount > 286 || distanceCount > 30 || state == STATE_ERROR) {
+        state = STATE_ERROR;
+        return;
+    }
+
+    uint8_t lengths[286 + 30] = {};
+    for (size_t i = 0; i < codeLengthCount; ++i) {
+        lengths[CODE_LENGTH_ORDER[i]] = bits(3);
+    }
+
+    // the code lengths of both codes are compressed with a third code
+    InflateHuffman codeLengths;
+    if (!buildHuffman(codeLengths, lengths, 19)) {
+        state = STATE_ERROR;
+        return;
+    }
+
+    size_t index = 0;
+    while (index < lengthCount + distanceCount) {
+        int symbol = decode(codeLengths);
+        if (symbol < 0 || state == STATE_ERROR) {
+            state = STATE_ERROR;
+            return;
+        }
+
+        if (symbol < 16) {
+            lengths[index++] = symbol;
+            continue;
+        }
+
+        // 16 repeats the last length, 17 and 18 repeat zeros
+        uint8_t length = 0;
+        uint8_t repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                state = STATE_ERROR;
+                return;
+            }
+            length = lengths[index - 1];
+            repeat = 3 + bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + bits(3);
+        } else {
+            repeat = 11 + bits(7);
+        }
+
+        if (index + repeat > lengthCount + distanceCount) {
+            state = STATE_ERROR;
+            return;
+        }
+        while (repeat-- > 0) {
+            lengths[index++] = length;
+        }
+    }
+
+    // without an end of block code the block could never end
+    if (state == STATE_ERROR || lengths[256] == 0 || !buildHuffman(dynamicLengths, lengths, lengthCount) || !buildHuffman(dynamicDistances, lengths + lengthCount, distanceCount)) {
+        state = STATE_ERROR;
+        return;
+    }
+
+    lengthCode = &dynamicLengths;
+    distanceCode = &dynamicDistances;
+    state = STATE_HUFFMAN;
+}
+
+size_t InflateStream::readBytes(char* buffer, size_t length)
+{
+    size_t count = 0;
+    if (peeked >= 0 && length > 0) {
+        buffer[count++] = peeked;
+        peeked = -1;
+    }
+
+    while (count < length) {
+        // a match can be longer than the space in the buffer, so the rest is copied on the next read
+        if (copyLength > 0) {
+            uint8_t c = window[(windowPosition - copyDistance) % INFLATE_WINDOW_SIZE];
+            window[windowPosition++ % INFLATE_WINDOW_SIZE] = c;
+            buffer[count++] = c;
+            copyLength--;
+            continue;
+        }
+
+        switch (state) {
+        case STATE_GZIP_HEADER:
+            readGzipHeader();
+            break;
+        case STATE_BLOCK_HEADER:
+            readBlockHeader();
+            break;
+        case STATE_STORED:
+            if (storedLeft == 0) {
+                state = STATE_BLOCK_HEADER;
+            } else {
+                int c = nextByte();
+                if (c >= 0) {
+                    window[windowPosition++ % INFLATE_WINDOW_SIZE] = c;
+                    buffer[count++] = c;
+                    storedLeft--;
+                }
+            }
+            break;
+        case STATE_HUFFMAN: {
+            int symbol = decode(*lengthCode);
+            if (state == STATE_ERROR || symbol < 0 || symbol > 285) {
+                state = STATE_ERROR;
+            } else if (symbol < 256) {
+                window[windowPosition++ % INFLATE_WINDOW_SIZE] = symbol;
+                buffer[count++] = symbol;
+            } else if (symbol == 256) {
+                state = STATE_BLOCK_HEADER;
+            } else {
+                symbol -= 257;
+                copyLength = LENGTH_BASES[symbol] + bits(LENGTH_EXTRA[symbol]);
+                int distance = decode(*distanceCode);
+                if (distance < 0 || distance > 29) {
+                    state = STATE_ERROR;
+                    copyLength = 0;
+                    break;
+                }
+                copyDistance = DISTANCE_BASES[distance] + bits(DISTANCE_EXTRA[distance]);
+                if (state == STATE_ERROR || copyDistance > windowPosition) {
+                    state = STATE_ERROR;
+                    copyLength = 0;
+                }
+            }
+            break;
+        }
+        case STATE_END:
+        case STATE_ERROR:
+            return count;
+        }
+    }
+
+    return count;
+}
+
+int InflateStream::available()
+{
+    if (peeked >= 0 || copyLength > 0) {
+        return 1 + copyLength;
+    }
+    if (state == STATE_END || state == STATE_ERROR) {
+        return 0;
+    }
+
+    // every compressed byte that is already here turns into at least one byte, except in block headers
+    return inputSize - inputPosition + stream->available();
+}
+
+int InflateStream::read()
+{
+    char c;
+    return readBytes(&c, 1) == 1 ? (uint8_t)c : -1;
+}
+
+int InflateStream::peek()
+{
+    if (peeked < 0) {
+        char c;
+        if (readBytes(&c, 1) == 1) {
+            peeked = (uint8_t)c;
+        }
+    }
+
+    return peeked;
+}
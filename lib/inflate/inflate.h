@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// deflate can refer back up to 32 KiB, so a smaller window would break valid responses
+#define INFLATE_WINDOW_SIZE 32768
+
+/**
+ * A canonical huffman code, stored as the number of codes per length and the symbols in code order.
+ */
+struct InflateHuffman {
+    uint16_t counts[16];
+    uint16_t symbols[288];
+};
+
+/**
+ * Decompresses a gzip stream (RFC 1952 and 1951) while it is read.
+ * Only the window and a small input buffer are kept, the output goes straight into the buffer of the reader,
+ * so the whole object is about 34 KiB and should be allocated on the heap.
+ * The stream ends early if the data is damaged or the input ends before the last block, see failed.
+ * The crc32 in the trailer isn't checked since the reader usually stops at the end of the calender before that.
+ */
+class InflateStream : public Stream {
+public:
+    explicit InflateStream(Stream* stream = nullptr)
+        : stream(stream)
+    {
+    }
+
+    /**
+     * Starts over with a new gzip stream, the window is reused.
+     */
+    void begin(Stream* stream);
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char* buffer, size_t length) override;
+
+    // the stream is only read
+    size_t write(uint8_t c)
+    {
+        return 0;
+    }
+
+    /**
+     * True if the input wasn't a valid gzip stream or ended too early.
+     */
+    bool failed() const { return state == STATE_ERROR; }
+
+    /**
+     * The number of compressed bytes read so far, including the gzip header.
+     */
+    size_t compressedBytes() const { return inputTotal - (inputSize - inputPosition); }
+
+private:
+    enum State : uint8_t {
+        STATE_GZIP_HEADER,
+        STATE_BLOCK_HEADER,
+        STATE_STORED,
+        STATE_HUFFMAN,
+        STATE_END,
+        STATE_ERROR,
+    };
+
+    int nextByte();
+    uint32_t bits(uint8_t count);
+    int decode(const InflateHuffman& huffman);
+    void readGzipHeader();
+    void readBlockHeader();
+    void readDynamicTables();
+
+    Stream* stream;
+    State state = STATE_GZIP_HEADER;
+    bool lastBlock = false;
+    uint8_t bitCount = 0;
+    uint32_t bitBuffer = 0;
+    uint16_t storedLeft = 0;
+    uint16_t copyLength = 0;
+    uint16_t copyDistance = 0;
+    int peeked = -1;
+    size_t inputSize = 0;
+    size_t inputPosition = 0;
+    size_t inputTotal = 0;
+    size_t windowPosition = 0; // total output, the window is written at windowPosition % INFLATE_WINDOW_SIZE
+    const InflateHuffman* lengthCode = nullptr;
+    const InflateHuffman* distanceCode = nullptr;
+    InflateHuffman dynamicLengths;
+    InflateHuffman dynamicDistances;
+    uint8_t input[256];
+    uint8_t window[INFLATE_WINDOW_SIZE];
+};
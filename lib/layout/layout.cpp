@@ -0,0 +1,181 @@
+#include "layout.h"
+
+#include <string.h>
+
+const GFXglyph* FontMetrics::glyph(char c) const
+{
+    // characters outside of the font are skipped by Adafruit GFX (see charBounds)
+    uint8_t code = c;
+    return code >= font->first && code <= font->last ? &font->glyph[code - font->first] : nullptr;
+}
+
+int16_t FontMetrics::advanceOf(char c) const
+{
+    auto g = glyph(c);
+    return g != nullptr ? g->xAdvance : 0;
+}
+
+int16_t FontMetrics::extentOf(char c) const
+{
+    auto g = glyph(c);
+    if (g == nullptr) {
+        return 0;
+    }
+
+    int16_t extent = g->xOffset + g->width;
+    return extent > g->xAdvance ? extent : g->xAdvance;
+}
+
+int16_t FontMetrics::overhangOf(char c) const
+{
+    auto g = glyph(c);
+    return g != nullptr && g->xOffset < 0 ? g->xOffset : 0;
+}
+
+int16_t FontMetrics::advance(const char* text, size_t length) const
+{
+    int16_t advance = 0;
+    for (size_t i = 0; i < length; ++i) {
+        advance += advanceOf(text[i]);
+    }
+
+    return advance;
+}
+
+int16_t FontMetrics::width(const char* text, size_t length) const
+{
+    // the glyph that reaches the furthest decides, characters outside of the font don't reach anywhere
+    int16_t advance = 0;
+    int16_t width = 0;
+    for (size_t i = 0; i < length; ++i) {
+        int16_t extent = extentOf(text[i]);
+        if (advance + extent > width) {
+            width = advance + extent;
+        }
+        advance += advanceOf(text[i]);
+    }
+
+    return width;
+}
+
+int16_t FontMetrics::left(const char* text) const
+{
+    // skipped characters in front don't move the cursor, so the first glyph that is in the font starts the text
+    for (; *text != '\0'; ++text) {
+        if (glyph(*text) != nullptr) {
+            return overhangOf(*text);
+        }
+    }
+
+    return 0;
+}
+
+int16_t FontMetrics::fit(char* target, const char* text, int16_t maxWidth) const
+{
+    size_t length = strnlen(text, LAYOUT_TEXT_SIZE - 1);
+    int16_t textWidth = width(text, length);
+    if (textWidth <= maxWidth && text[length] == '\0') {
+        memcpy(target, text, length);
+        target[length] = '\0';
+        return textWidth;
+    }
+
+    // the longest start that leaves room for the ellipsis, without a space in front of it
+    const size_t ellipsisLength = strlen(LAYOUT_ELLIPSIS);
+    int16_t room = maxWidth - width(LAYOUT_ELLIPSIS, ellipsisLength);
+    size_t cut = 0;
+    for (int16_t advance = 0; cut < length && cut < LAYOUT_TEXT_SIZE - 1 - ellipsisLength; ++cut) {
+        if (advance + extentOf(text[cut]) > room) {
+            break;
+        }
+        advance += advanceOf(text[cut]);
+    }
+    while (cut > 0 && text[cut - 1] == ' ') {
+        cut--;
+    }
+
+    memcpy(target, text, cut);
+    memcpy(target + cut, LAYOUT_ELLIPSIS, ellipsisLength + 1);
+    return width(target, cut + ellipsisLength);
+}
+
+DisplayItem* DisplayList::add(DisplayItemKind kind, xy_t pos, xy_t dim)
+{
+    if (count == LAYOUT_LIST_SIZE) {
+        return nullptr;
+    }
+
+    DisplayItem& item = items[count++];
+    item.kind = kind;
+    item.pos = pos;
+    item.dim = dim;
+    item.text[0] = '\0';
+    return &item;
+}
+
+DisplayItem* DisplayList::addText(const FontMetrics& metrics, xy_t cursor, int16_t top, int16_t bottom, color_t color, const char* text, int16_t maxWidth)
+{
+    char fitted[LAYOUT_TEXT_SIZE];
+    int16_t width = metrics.fit(fitted, text, maxWidth);
+    int16_t left = fitted[0] != '\0' ? metrics.left(fitted) : 0;
+    DisplayItem* item = add(ITEM_TEXT, { (int16_t)(cursor.x + left), top }, { (int16_t)(width - left), (int16_t)(bottom - top) });
+    if (item == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(item->text, fitted, sizeof(fitted));
+    item->cursor = cursor;
+    item->color = color;
+    item->font = metrics.font;
+    return item;
+}
+
+/**
+ * If the rectangle is already within one of the fades after the given item, like the text of a header on its gradient.
+ */
+bool DisplayList::faded(xy_t from, xy_t to, size_t since) const
+{
+    for (size_t i = since; i < count; ++i) {
+        const DisplayItem& fade = items[i];
+        if (from.x >= fade.pos.x && from.y >= fade.pos.y && to.x <= fade.pos.x + fade.dim.x && to.y <= fade.pos.y + fade.dim.y) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void DisplayList::fadeBand(xy_t bandPos, xy_t bandDim, color_t c1, color_t c2)
+{
+    size_t itemCount = count;
+    for (size_t i = 0; i < itemCount; ++i) {
+        const DisplayItem& item = items[i];
+        xy_t from = {
+            item.pos.x > bandPos.x ? item.pos.x : bandPos.x,
+            item.pos.y > bandPos.y ? item.pos.y : bandPos.y,
+        };
+        xy_t to = {
+            (int16_t)(item.pos.x + item.dim.x < bandPos.x + bandDim.x ? item.pos.x + item.dim.x : bandPos.x + bandDim.x),
+            (int16_t)(item.pos.y + item.dim.y < bandPos.y + bandDim.y ? item.pos.y + item.dim.y : bandPos.y + bandDim.y),
+        };
+        if (from.x >= to.x || from.y >= to.y || item.kind == ITEM_FADE_2C || faded(from, to, itemCount)) {
+            continue;
+        }
+
+        DisplayItem* fade = add(ITEM_FADE_2C, from, to - from);
+        if (fade == nullptr) {
+            return;
+        }
+        fade->bandPos = bandPos;
+        fade->bandDim = bandDim;
+        fade->color = c1;
+        fade->color2 = c2;
+    }
+}
+
+void DisplayList::clear()
+{
+    count = 0;
+    fitCount = 0;
+    overflow = false;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dither.h"
+
+// long enough for a summary with an ellipsis
+#ifndef LAYOUT_TEXT_SIZE
+#define LAYOUT_TEXT_SIZE 24
+#endif
+
+// a full screen has less than 8 lines, each with a gradient, a text and maybe a fade
+#ifndef LAYOUT_LIST_SIZE
+#define LAYOUT_LIST_SIZE 48
+#endif
+
+#define LAYOUT_ELLIPSIS "..."
+
+/**
+ * Measures text from the glyph array of a GFXfont, without rasterizing it like getTextBounds does.
+ * Characters outside of the font are skipped like Adafruit GFX does, so they don't move the cursor.
+ * It only points to the font, so it can be constexpr and the glyphs are read from flash where the font already is.
+ * Tables copied from the glyphs would have to be built in RAM on every boot,
+ * the fonts of Adafruit GFX are only const and not constexpr, so the compiler can't read them.
+ */
+struct FontMetrics {
+    constexpr explicit FontMetrics(const GFXfont& font)
+        : font(&font)
+    {
+    }
+
+    /**
+     * How far the cursor moves when the text is printed, same as the advance of a TextRun.
+     */
+    int16_t advance(const char* text, size_t length) const;
+
+    /**
+     * How far the text reaches from the cursor, which is a bit more than the advance if the last glyph overhangs.
+     */
+    int16_t width(const char* text, size_t length) const;
+
+    /**
+     * Where the first glyph of the text starts relative to the cursor.
+     */
+    int16_t left(const char* text) const;
+
+    /**
+     * Copies the text into target (of LAYOUT_TEXT_SIZE) and cuts it with an ellipsis if it's wider than maxWidth.
+     * Returns the width of the copied text.
+     */
+    int16_t fit(char* target, const char* text, int16_t maxWidth) const;
+
+    const GFXfont* font;
+
+private:
+    /**
+     * The glyph of the character, nullptr if it isn't in the font.
+     */
+    const GFXglyph* glyph(char c) const;
+
+    int16_t advanceOf(char c) const;
+    int16_t extentOf(char c) const; // how far the glyph reaches to the right of the cursor
+    int16_t overhangOf(char c) const; // how far the glyph reaches to the left of the cursor, 0 or negative
+};
+
+enum DisplayItemKind : uint8_t {
+    ITEM_TEXT, // the text in font and color at cursor
+    ITEM_GRADIENT_2C, // a horizontal gradient from color to color2 filling the box
+    ITEM_GRADIENT_3C,
+    ITEM_FADE_2C, // fades whatever is in the box into color2, the fade runs over all of band
+};
+
+/**
+ * One thing to draw. The box is everything the item may touch, the canvas only needs to draw it if the box is visible.
+ */
+struct DisplayItem {
+    DisplayItemKind kind;
+    xy_t pos; // top left of the box
+    xy_t dim;
+    xy_t cursor; // for text
+    xy_t bandPos; // for fades
+    xy_t bandDim;
+    color_t color;
+    color_t color2;
+    const GFXfont* font;
+    char text[LAYOUT_TEXT_SIZE];
+};
+
+/**
+ * The result of a layout pass that a draw pass executes in order.
+ */
+struct DisplayList {
+    DisplayItem items[LAYOUT_LIST_SIZE];
+    size_t count;
+    size_t fitCount; // how many of the laid out entries are completely visible
+    bool overflow; // if some entries didn't fit
+
+    /**
+     * Returns a new item at the end of the list, nullptr if the list is full.
+     */
+    DisplayItem* add(DisplayItemKind kind, xy_t pos, xy_t dim);
+
+    /**
+     * Adds a text that starts at the cursor and fills the line box from top to bottom.
+     */
+    DisplayItem* addText(const FontMetrics& metrics, xy_t cursor, int16_t top, int16_t bottom, color_t color, const char* text, int16_t maxWidth);
+
+    /**
+     * Adds fades over the part of every item so far that is within the band, instead of one over the whole band,
+     * so nothing is faded that is blank anyway.
+     */
+    void fadeBand(xy_t bandPos, xy_t bandDim, color_t c1, color_t c2);
+
+    void clear();
+
+private:
+    bool faded(xy_t from, xy_t to, size_t since) const;
+};
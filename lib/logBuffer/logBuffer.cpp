@@ -0,0 +1,189 @@
+#include "logBuffer.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+// a record is valid if its sequence is its index + 1, it is 0 while it is written
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+};
+
+static LogSlot slots[LOG_RECORDS];
+static std::atomic<uint32_t> writeIndex(0);
+static uint32_t readIndex = 0;
+
+void writeLog(uint8_t level, uint32_t time, const char* tag, const char* format, const uintptr_t* args, size_t argCount)
+{
+    uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+    LogSlot& slot = slots[index % LOG_RECORDS];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.record.time = time;
+    slot.record.level = level;
+    slot.record.argCount = argCount;
+    slot.record.tag = tag;
+    slot.record.format = format;
+    memcpy(slot.record.args, args, argCount * sizeof(uintptr_t));
+
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * Copies the record with the given index.
+ * Returns false if it was overwritten or is still being written.
+ */
+static bool readRecord(uint32_t index, LogRecord& record)
+{
+    LogSlot& slot = slots[index % LOG_RECORDS];
+    if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+        return false;
+    }
+
+    record = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+}
+
+/**
+ * Calls func for every record that wasn't read yet and returns how many there were.
+ * The records that were overwritten before they could be read are counted in lost.
+ */
+template <typename F>
+static size_t readRecords(uint32_t& lost, F func)
+{
+    uint32_t end = writeIndex.load(std::memory_order_acquire);
+    lost = 0;
+    if (end - readIndex > LOG_RECORDS) {
+        lost = end - readIndex - LOG_RECORDS;
+        readIndex = end - LOG_RECORDS;
+    }
+
+    size_t count = 0;
+    LogRecord record;
+    for (; readIndex != end; ++readIndex) {
+        if (readRecord(readIndex, record)) {
+            func(record);
+            count++;
+        } else {
+            lost++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Formats one conversion of the format at a time with snprintf, so everything printf can do with integers works.
+ * Returns the position after the conversion.
+ */
+static const char* formatArg(Print& out, const char* spec, uintptr_t arg)
+{
+    char conversion[16];
+    size_t length = strspn(spec + 1, "-+ #0123456789.hlzjt") + 2;
+    if (length >= sizeof(conversion)) {
+        out.write((const uint8_t*)spec, 1);
+        return spec + 1;
+    }
+
+    memcpy(conversion, spec, length);
+    conversion[length] = '\0';
+    char modifier = length > 2 ? conversion[length - 2] : '\0';
+
+    char buffer[64];
+    switch (conversion[length - 1]) {
+    case 'd':
+    case 'i':
+        if (modifier == 'l' || modifier == 'z' || modifier == 'j' || modifier == 't') {
+            snprintf(buffer, sizeof(buffer), conversion, (long)arg);
+        } else {
+            snprintf(buffer, sizeof(buffer), conversion, (int)arg);
+        }
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        if (modifier == 'l' || modifier == 'z' || modifier == 'j' || modifier == 't') {
+            snprintf(buffer, sizeof(buffer), conversion, (unsigned long)arg);
+        } else {
+            snprintf(buffer, sizeof(buffer), conversion, (unsigned)arg);
+        }
+        break;
+    case 'c':
+        snprintf(buffer, sizeof(buffer), conversion, (int)arg);
+        break;
+    case 's':
+        snprintf(buffer, sizeof(buffer), conversion, arg != 0 ? (const char*)arg : "(null)");
+        break;
+    case 'p':
+        snprintf(buffer, sizeof(buffer), conversion, (void*)arg);
+        break;
+    default:
+        snprintf(buffer, sizeof(buffer), "%s", conversion);
+        break;
+    }
+
+    out.print(buffer);
+    return spec + length;
+}
+
+size_t flushLog(Print& out)
+{
+    uint32_t lost;
+    size_t count = readRecords(lost, [&](const LogRecord& record) {
+        out.printf("%c (%u) %s: ", record.level, (unsigned)record.time, record.tag);
+
+        size_t arg = 0;
+        const char* format = record.format;
+        while (*format) {
+            const char* percent = strchr(format, '%');
+            if (percent == nullptr) {
+                out.print(format);
+                break;
+            }
+
+            out.write((const uint8_t*)format, percent - format);
+            if (percent[1] == '%') {
+                out.write('%');
+                format = percent + 2;
+            } else {
+                format = formatArg(out, percent, arg < record.argCount ? record.args[arg++] : 0);
+            }
+        }
+
+        out.println();
+    });
+
+    if (lost > 0) {
+        out.printf("%u log records lost\n", (unsigned)lost);
+    }
+
+    return count;
+}
+
+size_t dumpLog(Print& out)
+{
+    out.write((const uint8_t*)LOG_DUMP_MAGIC, 4);
+    uint32_t lost;
+    size_t count = readRecords(lost, [&](const LogRecord& record) {
+        // pointers are written as 32 bit, which is all they are on the device
+        uint32_t words[4 + LOG_MAX_ARGS] = {
+            record.time,
+            (uint32_t)record.level | (uint32_t)record.argCount << 8,
+            (uint32_t)(uintptr_t)record.tag,
+            (uint32_t)(uintptr_t)record.format,
+        };
+        for (size_t i = 0; i < record.argCount; ++i) {
+            words[4 + i] = (uint32_t)record.args[i];
+        }
+        out.write((const uint8_t*)words, (4 + record.argCount) * sizeof(uint32_t));
+    });
+
+    // a record with level 0 ends the dump, its time is the number of lost records
+    uint32_t end[2] = { lost, 0 };
+    out.write((const uint8_t*)end, sizeof(end));
+    return count;
+}
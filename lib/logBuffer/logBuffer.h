@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Print.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#ifdef ESP_PLATFORM
+#include <soc/soc_memory_layout.h>
+#endif
+
+#ifndef LOG_RECORDS
+#define LOG_RECORDS 64
+#endif
+
+#define LOG_MAX_ARGS 6
+
+// the start of a binary dump, see bench/decode_log.py
+#define LOG_DUMP_MAGIC "LOGB"
+
+/**
+ * A log line that isn't formatted yet.
+ * The format, the tag and all string arguments are only pointers,
+ * so they must still exist when the log is flushed, which string literals do.
+ */
+struct LogRecord {
+    uint32_t time;
+    uint8_t level;
+    uint8_t argCount;
+    const char* tag;
+    const char* format;
+    uintptr_t args[LOG_MAX_ARGS];
+};
+
+/**
+ * Adds a record to the ring buffer, the oldest record is overwritten if it is full.
+ * This doesn't block and can be called from any task.
+ */
+void writeLog(uint8_t level, uint32_t time, const char* tag, const char* format, const uintptr_t* args, size_t argCount);
+
+template <typename T>
+inline uintptr_t logArg(T value)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value, "only integers and pointers can be logged deferred");
+    static_assert(sizeof(T) <= sizeof(uintptr_t), "the argument is larger than a pointer");
+    static_assert(!std::is_same<T, char*>::value, "a string buffer changes before the log is flushed, log its numbers or a literal");
+    return (uintptr_t)value;
+}
+
+/**
+ * Only strings in flash are recorded, that are the literals and constant strings,
+ * anything else, like the c_str of a String, may be gone when the log is flushed.
+ */
+inline uintptr_t logArg(const char* value)
+{
+#ifdef ESP_PLATFORM
+    if (value != nullptr && !esp_ptr_in_drom(value)) {
+        return (uintptr_t) "<not a constant string>";
+    }
+#endif
+    return (uintptr_t)value;
+}
+
+/**
+ * A string that isn't constant but surely exists until the log is flushed, see LOG_KEPT.
+ */
+struct LogKeptString {
+    const char* value;
+};
+
+inline uintptr_t logArg(LogKeptString string)
+{
+    return (uintptr_t)string.value;
+}
+
+template <typename... Args>
+inline void deferLog(uint8_t level, uint32_t time, const char* tag, const char* format, Args... args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments to log deferred");
+    const uintptr_t values[] = { logArg(args)..., 0 };
+    writeLog(level, time, tag, format, values, sizeof...(Args));
+}
+
+/**
+ * Formats all records that weren't flushed yet, like the immediate log would have printed them.
+ * Returns the number of records, records that were overwritten before the flush are reported as one line.
+ */
+size_t flushLog(Print& out);
+
+/**
+ * Writes all records that weren't flushed yet without formatting them, which is a lot less to send.
+ * The pointers are resolved with the firmware by bench/decode_log.py.
+ */
+size_t dumpLog(Print& out);
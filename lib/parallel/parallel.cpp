@@ -0,0 +1,203 @@
+#include "parallel.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+struct ConcurrentCall {
+    void (*func)(size_t, void*);
+    void* context;
+    size_t index;
+    SemaphoreHandle_t done;
+};
+
+static void runCall(void* parameters)
+{
+    auto call = (ConcurrentCall*)parameters;
+    call->func(call->index, call->context);
+    xSemaphoreGive(call->done);
+    vTaskDelete(nullptr);
+}
+
+void runConcurrently(size_t count, void (*func)(size_t index, void* context), void* context, uint32_t stackSize)
+{
+    ConcurrentCall calls[PARALLEL_MAX_TASKS];
+    SemaphoreHandle_t done = xSemaphoreCreateCounting(PARALLEL_MAX_TASKS, 0);
+    size_t started = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (done != nullptr && i < PARALLEL_MAX_TASKS) {
+            calls[i] = { func, context, i, done };
+            if (xTaskCreate(runCall, "concurrent", stackSize, &calls[i], 1, nullptr) == pdPASS) {
+                started++;
+                continue;
+            }
+        }
+
+        func(i, context);
+    }
+
+    for (size_t i = 0; i < started; ++i) {
+        xSemaphoreTake(done, portMAX_DELAY);
+    }
+
+    if (done != nullptr) {
+        vSemaphoreDelete(done);
+    }
+}
+
+static uint32_t nowMicros()
+{
+    return esp_timer_get_time();
+}
+
+// an event group has 24 usable bits, one for every stage that is done
+struct Pipeline {
+    PipelineStage* stages;
+    EventGroupHandle_t done;
+    uint32_t start;
+};
+
+static void waitForStages(Pipeline& pipeline, uint32_t stages)
+{
+    if (stages != 0) {
+        xEventGroupWaitBits(pipeline.done, stages, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+}
+
+static void markStageDone(Pipeline& pipeline, size_t index)
+{
+    xEventGroupSetBits(pipeline.done, STAGE_BIT(index));
+}
+
+static bool createPipeline(Pipeline& pipeline)
+{
+    pipeline.done = xEventGroupCreate();
+    return pipeline.done != nullptr;
+}
+
+static void destroyPipeline(Pipeline& pipeline)
+{
+    vEventGroupDelete(pipeline.done);
+}
+
+#else
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+void runConcurrently(size_t count, void (*func)(size_t index, void* context), void* context, uint32_t stackSize)
+{
+    std::thread threads[PARALLEL_MAX_TASKS];
+    for (size_t i = 0; i < count; ++i) {
+        try {
+            if (i < PARALLEL_MAX_TASKS) {
+                threads[i] = std::thread(func, i, context);
+                continue;
+            }
+        } catch (const std::system_error&) {
+        }
+
+        func(i, context);
+    }
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+static uint32_t nowMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+struct Pipeline {
+    PipelineStage* stages;
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t done;
+    uint32_t start;
+};
+
+static void waitForStages(Pipeline& pipeline, uint32_t stages)
+{
+    std::unique_lock<std::mutex> lock(pipeline.mutex);
+    pipeline.changed.wait(lock, [&]() { return (pipeline.done & stages) == stages; });
+}
+
+static void markStageDone(Pipeline& pipeline, size_t index)
+{
+    std::lock_guard<std::mutex> lock(pipeline.mutex);
+    pipeline.done |= STAGE_BIT(index);
+    pipeline.changed.notify_all();
+}
+
+static bool createPipeline(Pipeline& pipeline)
+{
+    pipeline.done = 0;
+    return true;
+}
+
+static void destroyPipeline(Pipeline& pipeline)
+{
+}
+
+#endif
+
+static void runStage(size_t index, void* context)
+{
+    auto& pipeline = *(Pipeline*)context;
+    auto& stage = pipeline.stages[index];
+    waitForStages(pipeline, stage.dependencies);
+    stage.start = nowMicros() - pipeline.start;
+    stage.func();
+    stage.end = nowMicros() - pipeline.start;
+    markStageDone(pipeline, index);
+}
+
+void runPipeline(PipelineStage* stages, size_t count, uint32_t stackSize)
+{
+    Pipeline pipeline;
+    pipeline.stages = stages;
+    pipeline.start = nowMicros();
+    if (!createPipeline(pipeline)) {
+        // one after another still works since the dependencies come first
+        for (size_t i = 0; i < count; ++i) {
+            stages[i].start = nowMicros() - pipeline.start;
+            stages[i].func();
+            stages[i].end = nowMicros() - pipeline.start;
+        }
+        return;
+    }
+
+    runConcurrently(count, runStage, &pipeline, stackSize);
+    destroyPipeline(pipeline);
+}
+
+uint32_t pipelineCriticalPath(const PipelineStage* stages, size_t count)
+{
+    uint32_t path = 0;
+    uint32_t candidates = count > 0 ? STAGE_BIT(count) - 1 : 0;
+    while (candidates != 0) {
+        size_t last = count;
+        for (size_t i = 0; i < count; ++i) {
+            if ((candidates & STAGE_BIT(i)) && (last == count || stages[i].end > stages[last].end)) {
+                last = i;
+            }
+        }
+
+        path |= STAGE_BIT(last);
+        candidates = stages[last].dependencies;
+    }
+
+    return path;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PARALLEL_MAX_TASKS 8
+
+/**
+ * Runs func(index, context) for every index below count at the same time
+ * and returns once all of them are done.
+ * On the ESP32 every call gets its own FreeRTOS task with the given stack size, on the host a std::thread.
+ * Calls that don't get a task (more than PARALLEL_MAX_TASKS or out of memory) run one after another in the caller.
+ */
+void runConcurrently(size_t count, void (*func)(size_t index, void* context), void* context, uint32_t stackSize = 8192);
+
+/**
+ * A step of the boot pipeline.
+ * The stages must be ordered so that every stage comes after its dependencies.
+ */
+struct PipelineStage {
+    const char* name;
+    void (*func)();
+    uint32_t dependencies; // bit i set means stage i has to be done before this one starts
+
+    // microseconds since the pipeline started, filled by runPipeline
+    uint32_t start;
+    uint32_t end;
+};
+
+#define STAGE_BIT(stage) (1u << (stage))
+
+/**
+ * Runs every stage as soon as all its dependencies are done, independent stages run at the same time.
+ * Returns once all stages are done.
+ */
+void runPipeline(PipelineStage* stages, size_t count, uint32_t stackSize = 8192);
+
+/**
+ * Returns the stages that decided how long the pipeline took as bits like the dependencies.
+ * That is the stage that ended last, the dependency of it that ended last and so on.
+ */
+uint32_t pipelineCriticalPath(const PipelineStage* stages, size_t count);
@@ -0,0 +1,113 @@
+#include "profiler.h"
+
+const char* const PROFILE_PHASE_NAMES[PHASE_COUNT] = {
+    "associate",
+    "dhcp",
+    "ntp",
+    "http",
+    "download",
+    "parse",
+    "render",
+    "spi",
+    "busy",
+    "sleep",
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+uint32_t profileMicros()
+{
+    return esp_timer_get_time();
+}
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+#define LOCK() portENTER_CRITICAL(&lock)
+#define UNLOCK() portEXIT_CRITICAL(&lock)
+
+#else
+
+#include <chrono>
+#include <mutex>
+
+uint32_t profileMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::mutex lock;
+#define LOCK() lock.lock()
+#define UNLOCK() lock.unlock()
+
+#endif
+
+static ProfileCycle* currentCycle = nullptr;
+static uint32_t cycleStart = 0;
+
+void beginProfileCycle(ProfileLog& log)
+{
+    LOCK();
+    currentCycle = &log.cycles[log.cycleCount++ % PROFILE_CYCLES];
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        currentCycle->start[i] = PROFILE_UNUSED;
+        currentCycle->duration[i] = 0;
+    }
+    cycleStart = profileMicros();
+    UNLOCK();
+}
+
+void addProfilePhase(ProfilePhase phase, uint32_t startMicros, uint32_t micros)
+{
+    uint32_t start = (startMicros - cycleStart) / 1000;
+    uint32_t duration = (micros + 500) / 1000;
+
+    LOCK();
+    if (currentCycle != nullptr) {
+        if (start < currentCycle->start[phase]) {
+            currentCycle->start[phase] = start < PROFILE_UNUSED ? start : PROFILE_UNUSED - 1;
+        }
+
+        duration += currentCycle->duration[phase];
+        currentCycle->duration[phase] = duration < 0xFFFF ? duration : 0xFFFF;
+    }
+    UNLOCK();
+}
+
+const ProfileCycle* profileCycle(const ProfileLog& log, size_t age)
+{
+    if (age >= log.cycleCount || age >= PROFILE_CYCLES) {
+        return nullptr;
+    }
+
+    return &log.cycles[(log.cycleCount - 1 - age) % PROFILE_CYCLES];
+}
+
+void printProfileLog(const ProfileLog& log, Print& out)
+{
+    // every phase is printed as start+duration in milliseconds
+    out.printf("   cycle");
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        out.printf(" %11s", PROFILE_PHASE_NAMES[i]);
+    }
+    out.println();
+
+    for (size_t age = PROFILE_CYCLES; age-- > 0;) {
+        auto cycle = profileCycle(log, age);
+        if (cycle == nullptr) {
+            continue;
+        }
+
+        out.printf("%8u", log.cycleCount - (unsigned)age);
+        for (size_t i = 0; i < PHASE_COUNT; ++i) {
+            if (cycle->start[i] == PROFILE_UNUSED) {
+                out.printf(" %11s", "-");
+            } else {
+                out.printf(" %5u+%5u", cycle->start[i], cycle->duration[i]);
+            }
+        }
+        out.println();
+    }
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <Print.h>
+#include <Stream.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * The phases of a wake cycle that are worth watching for battery life.
+ */
+enum ProfilePhase {
+    PHASE_ASSOCIATE, // WiFi until the access point accepted us
+    PHASE_DHCP,
+    PHASE_NTP,
+    PHASE_HTTP, // until the response headers arrived
+    PHASE_DOWNLOAD, // waiting for the body
+    PHASE_PARSE,
+    PHASE_RENDER,
+    PHASE_SPI, // sending the frame to the panel
+    PHASE_BUSY, // the panel refreshing
+    PHASE_SLEEP, // starts when the device goes to deep sleep, so the start is the awake time
+    PHASE_COUNT,
+};
+
+extern const char* const PROFILE_PHASE_NAMES[PHASE_COUNT];
+
+#ifndef PROFILE_CYCLES
+#define PROFILE_CYCLES 8
+#endif
+
+#define PROFILE_UNUSED 0xFFFF
+
+/**
+ * The phases of one wake cycle in milliseconds since beginProfileCycle.
+ * Phases that happen more than once, like a download per calender, add up their durations,
+ * so the duration is the work done and not the time between the first start and the last end.
+ */
+struct ProfileCycle {
+    uint16_t start[PHASE_COUNT]; // PROFILE_UNUSED if the phase didn't happen
+    uint16_t duration[PHASE_COUNT];
+};
+
+/**
+ * The last PROFILE_CYCLES wake cycles, meant to be kept in RTC memory so they survive deep sleep.
+ */
+struct ProfileLog {
+    uint32_t cycleCount; // all cycles ever, the current one is at (cycleCount - 1) % PROFILE_CYCLES
+    ProfileCycle cycles[PROFILE_CYCLES];
+};
+
+/**
+ * Returns a monotonic time, esp_timer_get_time on the device and steady_clock on the host.
+ */
+uint32_t profileMicros();
+
+/**
+ * Starts a new cycle in the log, the following phases are recorded into it.
+ * Call it as early as possible after waking up.
+ */
+void beginProfileCycle(ProfileLog& log);
+
+/**
+ * Adds a phase that started at the given profileMicros and took the given time.
+ * This can be called from any task.
+ */
+void addProfilePhase(ProfilePhase phase, uint32_t startMicros, uint32_t micros);
+
+/**
+ * Returns the cycle that is the given number of cycles ago, 0 is the current one.
+ * Returns nullptr if the log doesn't go back that far.
+ */
+const ProfileCycle* profileCycle(const ProfileLog& log, size_t age);
+
+/**
+ * Prints one line per cycle, the oldest first.
+ */
+void printProfileLog(const ProfileLog& log, Print& out);
+
+/**
+ * Records the time between construction and destruction as a phase.
+ */
+class ProfileSpan {
+public:
+    explicit ProfileSpan(ProfilePhase phase)
+        : phase(phase)
+        , start(profileMicros())
+    {
+    }
+
+    ~ProfileSpan()
+    {
+        addProfilePhase(phase, start, profileMicros() - start);
+    }
+
+private:
+    ProfilePhase phase;
+    uint32_t start;
+};
+
+/**
+ * Passes a stream through and measures how long the reads block,
+ * so a streaming parser can tell the time waiting for data from the time parsing it.
+ */
+class ProfiledStream : public Stream {
+public:
+    explicit ProfiledStream(Stream* stream)
+        : stream(stream)
+    {
+    }
+
+    int available() override
+    {
+        return stream->available();
+    }
+
+    int read() override
+    {
+        uint32_t start = profileMicros();
+        int c = stream->read();
+        readMicros += profileMicros() - start;
+        return c;
+    }
+
+    int peek() override
+    {
+        return stream->peek();
+    }
+
+    size_t readBytes(char* buffer, size_t length) override
+    {
+        uint32_t start = profileMicros();
+        size_t count = stream->readBytes(buffer, length);
+        readMicros += profileMicros() - start;
+        return count;
+    }
+
+    // the stream is only read
+    size_t write(uint8_t c)
+    {
+        return 0;
+    }
+
+    uint32_t readMicros = 0;
+
+private:
+    Stream* stream;
+};
@@ -0,0 +1,70 @@
+#include "reconnect.h"
+
+static const char* const ATTEMPT_NAMES[ATTEMPT_KIND_COUNT] = { "cached", "scan" };
+
+static bool attempt(WiFiRadio& radio, const WiFiCache* cache, WiFiStats& stats)
+{
+    uint32_t start = radio.millis();
+    bool connected = radio.connect(cache, cache != nullptr ? RECONNECT_CACHED_TIMEOUT : RECONNECT_SCAN_TIMEOUT);
+    uint32_t millis = radio.millis() - start;
+
+    auto& entry = stats.attempts[stats.attemptCount++ % RECONNECT_STATS_SIZE];
+    entry = { cache != nullptr ? ATTEMPT_CACHED : ATTEMPT_SCAN, connected, (uint16_t)(millis < 0xFFFF ? millis : 0xFFFF) };
+    return connected;
+}
+
+bool reconnectWiFi(WiFiRadio& radio, WiFiCache& cache, WiFiStats& stats, time_t now)
+{
+    if (cache.valid) {
+        // after the lease ran out the address may belong to someone else, so only the access point is reused
+        WiFiCache directed = cache;
+        bool leased = now > 1000 && cache.leaseTime != 0 && now >= cache.leaseTime && now - cache.leaseTime < RECONNECT_LEASE_SECONDS;
+        if (!leased) {
+            directed.ip = 0;
+        }
+
+        if (attempt(radio, &directed, stats)) {
+            if (!leased) {
+                radio.remember(cache);
+                cache.leaseTime = now > 1000 ? now : 0;
+            }
+            return true;
+        }
+
+        // the access point changed its channel or is gone, the scan finds whatever is there now
+        cache.valid = false;
+        radio.disconnect();
+    }
+
+    if (!attempt(radio, nullptr, stats)) {
+        radio.disconnect();
+        return false;
+    }
+
+    radio.remember(cache);
+    cache.valid = true;
+    cache.leaseTime = now > 1000 ? now : 0;
+    return true;
+}
+
+void printWiFiStats(const WiFiStats& stats, Print& out)
+{
+    size_t count = stats.attemptCount < RECONNECT_STATS_SIZE ? stats.attemptCount : RECONNECT_STATS_SIZE;
+    for (uint8_t kind = 0; kind < ATTEMPT_KIND_COUNT; ++kind) {
+        unsigned attempts = 0, connected = 0, millis = 0;
+        for (size_t i = 0; i < count; ++i) {
+            auto& entry = stats.attempts[i];
+            if (entry.kind == kind) {
+                attempts++;
+                connected += entry.connected;
+                millis += entry.millis;
+            }
+        }
+        out.printf("%-6s %3u attempts %3u connected %5u ms average\n", ATTEMPT_NAMES[kind], attempts, connected, attempts > 0 ? millis / attempts : 0);
+    }
+
+    for (size_t age = count; age-- > 0;) {
+        auto& entry = stats.attempts[(stats.attemptCount - 1 - age) % RECONNECT_STATS_SIZE];
+        out.printf("%8u %-6s %-9s %5u ms\n", stats.attemptCount - (unsigned)age, ATTEMPT_NAMES[entry.kind], entry.connected ? "connected" : "failed", entry.millis);
+    }
+}
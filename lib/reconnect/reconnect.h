@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Print.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// a directed connect with a static address takes a few hundred milliseconds, if it takes longer something changed
+#define RECONNECT_CACHED_TIMEOUT 1500
+#define RECONNECT_SCAN_TIMEOUT 10000
+
+// the address is only reused as long as a typical dhcp lease lasts, after that only the access point is reused
+#define RECONNECT_LEASE_SECONDS (24 * 3600)
+
+#ifndef RECONNECT_STATS_SIZE
+#define RECONNECT_STATS_SIZE 16
+#endif
+
+/**
+ * The access point and address of the last successful connection, kept in RTC memory.
+ * All addresses are in the byte order of IPAddress, an ip of 0 means the address is requested by dhcp.
+ */
+struct WiFiCache {
+    bool valid;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+    time_t leaseTime; // when the address was received by dhcp, 0 if unknown
+};
+
+/**
+ * The way a connection was attempted.
+ */
+enum WiFiAttemptKind : uint8_t {
+    ATTEMPT_CACHED, // directly to the cached access point and channel, with the cached address if it's still leased
+    ATTEMPT_SCAN, // scanning all channels and asking dhcp for an address
+    ATTEMPT_KIND_COUNT,
+};
+
+struct WiFiAttempt {
+    WiFiAttemptKind kind;
+    bool connected;
+    uint16_t millis;
+};
+
+/**
+ * The last RECONNECT_STATS_SIZE attempts, meant to be kept in RTC memory like the ProfileLog.
+ */
+struct WiFiStats {
+    uint32_t attemptCount; // all attempts ever, the last one is at (attemptCount - 1) % RECONNECT_STATS_SIZE
+    WiFiAttempt attempts[RECONNECT_STATS_SIZE];
+};
+
+/**
+ * The parts of the WiFi driver the reconnect needs, so the fallbacks can be run against a fake on the host.
+ */
+class WiFiRadio {
+public:
+    virtual ~WiFiRadio() = default;
+
+    /**
+     * Connects to the configured network and blocks until there is an address or the timeout passed.
+     * With a cache the access point isn't searched, its ip is used if it isn't 0.
+     */
+    virtual bool connect(const WiFiCache* cache, uint32_t timeoutMillis) = 0;
+
+    /**
+     * Writes the access point and address of the current connection into the cache.
+     */
+    virtual void remember(WiFiCache& cache) = 0;
+
+    /**
+     * Stops a connection attempt so the next one starts clean.
+     */
+    virtual void disconnect() = 0;
+
+    virtual uint32_t millis() = 0;
+};
+
+/**
+ * Connects with the cached access point first and falls back to a full scan if that fails.
+ * The cache is updated after every successful scan and dropped after a failed cached attempt.
+ * Every attempt is recorded in stats. Times below 1000 mean the clock isn't set.
+ */
+bool reconnectWiFi(WiFiRadio& radio, WiFiCache& cache, WiFiStats& stats, time_t now);
+
+/**
+ * Prints the attempts, successes and average time of every kind of attempt and the last attempts, the oldest first.
+ */
+void printWiFiStats(const WiFiStats& stats, Print& out);
@@ -0,0 +1,40 @@
+#include "schedule.h"
+
+#include "civil.h"
+
+int32_t nextRenderChange(const ICalEntry* entries, size_t size, int32_t currentDay, uint8_t changes)
+{
+    // the days relative to the entry day on which each change happens
+    static const int8_t CHANGE_OFFSETS[] = { -SCHEDULE_WEEKDAY_DAYS, -1, 0, 1 };
+
+    int32_t next = SCHEDULE_NEVER;
+    for (size_t i = 0; i < size; ++i) {
+        // the entries are sorted, so no later entry can change anything before this one does
+        if (entries[i].day - SCHEDULE_WEEKDAY_DAYS >= next) {
+            break;
+        }
+
+        for (uint8_t change = 0; change < sizeof(CHANGE_OFFSETS); ++change) {
+            int32_t day = entries[i].day + CHANGE_OFFSETS[change];
+            if (changes & (1 << change) && day > currentDay && day < next) {
+                next = day;
+            }
+        }
+    }
+
+    return next;
+}
+
+int32_t nextWakeDay(const ICalEntry* entries, size_t size, int32_t currentDay, uint32_t millivolt, int32_t daysLeft, const SleepPolicy& policy)
+{
+    bool low = (millivolt > 0 && millivolt < policy.lowMillivolt) || (daysLeft >= 0 && daysLeft < policy.lowDays);
+    int32_t maxDay = currentDay + (low ? policy.maxDays * 2 : policy.maxDays);
+    int32_t next = nextRenderChange(entries, size, currentDay, low ? SCHEDULE_LOW_VOLTAGE_CHANGES : CHANGE_ALL);
+    return next < maxDay ? next : maxDay;
+}
+
+uint32_t sleepSeconds(time_t timestamp, const ICalEntry* entries, size_t size, uint32_t millivolt, int32_t daysLeft, const SleepPolicy& policy)
+{
+    int32_t wakeDay = nextWakeDay(entries, size, localDays(timestamp), millivolt, daysLeft, policy);
+    return fromLocalDays(wakeDay, SCHEDULE_WAKE_SECONDS) - timestamp;
+}
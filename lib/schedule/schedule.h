@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "iCal.h"
+
+// the header of a day in renderCalender is "Heute", "Morgen", the week day up to this many days ahead and the date after that
+#define SCHEDULE_WEEKDAY_DAYS 3
+
+// the time after local midnight to wake up at, late enough that the new day surely started on the RTC clock
+#define SCHEDULE_WAKE_SECONDS 7200
+
+#define SCHEDULE_NEVER INT32_MAX
+
+/**
+ * The reasons the rendered calender changes from one day to the next.
+ */
+enum ScheduleChange : uint8_t {
+    CHANGE_WEEKDAY = 0x01, // the date header of an entry turns into its week day
+    CHANGE_TOMORROW = 0x02, // an entry becomes "Morgen"
+    CHANGE_TODAY = 0x04, // an entry becomes "Heute"
+    CHANGE_EXPIRED = 0x08, // the day of an entry is over and it disappears
+    CHANGE_ALL = 0x0F,
+};
+
+struct SleepPolicy {
+    int32_t maxDays; // wake up at least this often, so changes of the calenders themselves show up eventually
+    uint32_t lowMillivolt; // below this only the changes that matter for taking out the bins are followed
+    int32_t lowDays; // the same if the battery is predicted to be empty in fewer days
+};
+
+// "Morgen" is the evening to put the bins out and an entry that is gone can't be missed
+#define SCHEDULE_LOW_VOLTAGE_CHANGES (CHANGE_TOMORROW | CHANGE_EXPIRED)
+
+/**
+ * Returns the first day after currentDay on which the entries are rendered differently,
+ * only looking at the given kinds of changes. Returns SCHEDULE_NEVER if they won't change anymore.
+ */
+int32_t nextRenderChange(const ICalEntry* entries, size_t size, int32_t currentDay, uint8_t changes = CHANGE_ALL);
+
+/**
+ * Returns the day to wake up next for the given entries and battery state, daysLeft is negative if unknown.
+ * At low voltage only SCHEDULE_LOW_VOLTAGE_CHANGES are followed and maxDays is doubled.
+ */
+int32_t nextWakeDay(const ICalEntry* entries, size_t size, int32_t currentDay, uint32_t millivolt, int32_t daysLeft, const SleepPolicy& policy);
+
+/**
+ * Returns the seconds until SCHEDULE_WAKE_SECONDS on the next wake day.
+ */
+uint32_t sleepSeconds(time_t timestamp, const ICalEntry* entries, size_t size, uint32_t millivolt, int32_t daysLeft, const SleepPolicy& policy);
@@ -0,0 +1,211 @@
+#include "snapshot.h"
+
+#include <string.h>
+
+// the dictionary only has the summaries of one calender, which are just a handful
+#define SNAPSHOT_MAX_SUMMARIES ICAL_MAX_SUMMARIES
+
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc)
+{
+    // half a byte at a time, which needs just 64 bytes of table
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0x0F] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0x0F] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
+
+/**
+ * Writes into a buffer and remembers if anything didn't fit.
+ */
+struct SnapshotWriter {
+    uint8_t* buffer;
+    size_t size;
+    size_t position;
+
+    void write(uint8_t byte)
+    {
+        if (position < size) {
+            buffer[position] = byte;
+        }
+        position++;
+    }
+
+    void writeVarint(uint32_t value)
+    {
+        while (value >= 0x80) {
+            write(value | 0x80);
+            value >>= 7;
+        }
+        write(value);
+    }
+};
+
+/**
+ * Reads from a buffer and remembers if it read past the end or found something invalid.
+ */
+struct SnapshotReader {
+    const uint8_t* buffer;
+    size_t size;
+    size_t position;
+    bool valid;
+
+    uint8_t read()
+    {
+        if (position >= size) {
+            valid = false;
+            return 0;
+        }
+
+        return buffer[position++];
+    }
+
+    uint32_t readVarint()
+    {
+        uint32_t value = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7) {
+            uint8_t byte = read();
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return value;
+            }
+        }
+
+        valid = false;
+        return 0;
+    }
+};
+
+static size_t findSummary(const uint8_t* summaries, size_t summaryCount, uint8_t summary)
+{
+    size_t index = 0;
+    while (index < summaryCount && summaries[index] != summary) {
+        index++;
+    }
+
+    return index;
+}
+
+/**
+ * The crc covers the version, flags and length as well as everything after the header.
+ */
+static uint32_t snapshotCrc(const uint8_t* buffer, uint16_t length)
+{
+    return crc32(buffer + SNAPSHOT_HEADER_SIZE, length - SNAPSHOT_HEADER_SIZE, crc32(buffer, 4));
+}
+
+size_t writeSnapshot(uint8_t* buffer, size_t size, const ICalEntry* entries, size_t count, uint8_t flags)
+{
+    SnapshotWriter writer = { buffer, size, SNAPSHOT_HEADER_SIZE };
+
+    // the ids of the summary pool are only valid until the next boot, so the dictionary has the texts
+    uint8_t summaries[SNAPSHOT_MAX_SUMMARIES];
+    size_t summaryCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (findSummary(summaries, summaryCount, entries[i].summary) == summaryCount) {
+            if (summaryCount == SNAPSHOT_MAX_SUMMARIES) {
+                return 0;
+            }
+            summaries[summaryCount++] = entries[i].summary;
+        }
+    }
+
+    writer.writeVarint(count);
+    writer.writeVarint(summaryCount);
+    for (size_t index = 0; index < summaryCount; ++index) {
+        for (const char* c = icalSummary(summaries[index]); *c; ++c) {
+            writer.write(*c);
+        }
+        writer.write('\0');
+    }
+
+    int32_t lastDay = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (entries[i].day < lastDay) {
+            return 0; // the list isn't sorted or starts before 1970
+        }
+
+        writer.writeVarint(entries[i].day - lastDay);
+        writer.writeVarint(findSummary(summaries, summaryCount, entries[i].summary));
+        writer.write(entries[i].source);
+        lastDay = entries[i].day;
+    }
+
+    if (writer.position > size || writer.position > 0xFFFF) {
+        return 0;
+    }
+
+    uint16_t length = writer.position;
+    buffer[0] = SNAPSHOT_VERSION;
+    buffer[1] = flags;
+    memcpy(buffer + 2, &length, sizeof(length));
+    uint32_t crc = snapshotCrc(buffer, length);
+    memcpy(buffer + 4, &crc, sizeof(crc));
+    return length;
+}
+
+bool readSnapshot(const uint8_t* buffer, size_t size, ICalEntry* entries, size_t& count, size_t maxSize, uint8_t* flags)
+{
+    count = 0;
+    if (size < SNAPSHOT_HEADER_SIZE || buffer[0] != SNAPSHOT_VERSION) {
+        return false;
+    }
+
+    uint16_t length;
+    uint32_t crc;
+    memcpy(&length, buffer + 2, sizeof(length));
+    memcpy(&crc, buffer + 4, sizeof(crc));
+    if (length < SNAPSHOT_HEADER_SIZE || length > size || snapshotCrc(buffer, length) != crc) {
+        return false;
+    }
+
+    SnapshotReader reader = { buffer, length, SNAPSHOT_HEADER_SIZE, true };
+    uint32_t entryCount = reader.readVarint();
+    uint32_t summaryCount = reader.readVarint();
+    if (entryCount > maxSize || summaryCount > SNAPSHOT_MAX_SUMMARIES) {
+        return false;
+    }
+
+    uint8_t summaries[SNAPSHOT_MAX_SUMMARIES];
+    for (size_t index = 0; index < summaryCount; ++index) {
+        const char* text = (const char*)buffer + reader.position;
+        while (reader.read() != '\0' && reader.valid) {
+        }
+
+        size_t textLength = (const char*)buffer + reader.position - text - 1;
+        if (!reader.valid || textLength >= ICAL_SUMMARY_SIZE) {
+            return false;
+        }
+        summaries[index] = internICalSummary(text, textLength);
+    }
+
+    int32_t day = 0;
+    for (size_t i = 0; i < entryCount && reader.valid; ++i) {
+        day += reader.readVarint();
+        uint32_t index = reader.readVarint();
+        uint8_t source = reader.read();
+        if (index >= summaryCount) {
+            return false;
+        }
+
+        entries[i] = { day, summaries[index], source };
+    }
+
+    if (!reader.valid || reader.position != length) {
+        return false;
+    }
+
+    count = entryCount;
+    if (flags != nullptr) {
+        *flags = buffer[1];
+    }
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "iCal.h"
+
+// increase this whenever the format changes, older snapshots are ignored then
+#define SNAPSHOT_VERSION 2
+
+// the list has every entry of the calender, there are no more entries after the last one
+#define SNAPSHOT_COMPLETE 0x01
+
+/**
+ * A snapshot is a compact copy of a sorted entry list, small enough to keep a few of them in RTC memory.
+ *
+ * It starts with the version, flags, total length and a crc32 of everything else.
+ * Then comes the number of entries, the summary dictionary (the text of every distinct summary)
+ * and the entries as day delta to the entry before, index into the dictionary and source.
+ * All numbers after the header are LEB128 varints, so most entries take 3 bytes.
+ */
+#define SNAPSHOT_HEADER_SIZE 8
+
+/**
+ * Writes the entries into the buffer.
+ * Returns the length of the snapshot or 0 if it doesn't fit into the buffer.
+ */
+size_t writeSnapshot(uint8_t* buffer, size_t size, const ICalEntry* entries, size_t count, uint8_t flags = 0);
+
+/**
+ * Reads the entries of a snapshot written by writeSnapshot, the summaries are added to the summary pool.
+ * Returns false if the snapshot is from another version, damaged or has more than maxSize entries,
+ * count is 0 then and nothing useful is in entries.
+ */
+bool readSnapshot(const uint8_t* buffer, size_t size, ICalEntry* entries, size_t& count, size_t maxSize, uint8_t* flags = nullptr);
+
+/**
+ * The crc32 that is used for snapshots, the same as zlib and ethernet use.
+ */
+uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
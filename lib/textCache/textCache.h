@@ -0,0 +1,210 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * A string that was rasterized once in a specific font and rotation.
+ * The bitmap is stored in the orientation of the panel (rows of the unrotated display, most significant bit first),
+ * so it can be copied into a frame buffer byte by byte.
+ */
+struct TextRun {
+    const GFXfont* font;
+    uint32_t hash;
+    uint8_t rotation;
+    int16_t x; // offset of the bitmap from the cursor, like getTextBounds returns it
+    int16_t y;
+    uint16_t width; // size of the bitmap in canvas coordinates
+    uint16_t height;
+    int16_t advance; // how far the cursor moves
+    uint16_t offset; // where the bitmap starts in the pool, followed by the text itself
+};
+
+/**
+ * Rasterizes text into a 1 bit bitmap with the panel orientation of a canvas with the given rotation.
+ */
+class TextRaster : public Adafruit_GFX {
+public:
+    TextRaster(uint8_t* bitmap, uint16_t width, uint16_t height, uint8_t rotation)
+        : Adafruit_GFX(rotation % 2 ? height : width, rotation % 2 ? width : height)
+        , bitmap(bitmap)
+    {
+        setRotation(rotation);
+        memset(bitmap, 0, size());
+    }
+
+    /**
+     * The bytes needed for a bitmap of the given size in canvas coordinates.
+     */
+    static size_t size(uint16_t width, uint16_t height, uint8_t rotation)
+    {
+        return rotation % 2 ? (height + 7) / 8 * width : (width + 7) / 8 * height;
+    }
+
+    size_t size() const
+    {
+        return (WIDTH + 7) / 8 * HEIGHT;
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override
+    {
+        if (x < 0 || x >= width() || y < 0 || y >= height()) {
+            return;
+        }
+
+        // same as Canvas3C::toPanel
+        int16_t t;
+        switch (getRotation()) {
+        case 1:
+            t = x;
+            x = WIDTH - y - 1;
+            y = t;
+            break;
+        case 2:
+            x = WIDTH - x - 1;
+            y = HEIGHT - y - 1;
+            break;
+        case 3:
+            t = x;
+            x = y;
+            y = HEIGHT - t - 1;
+            break;
+        }
+
+        bitmap[x / 8 + y * ((WIDTH + 7) / 8)] |= 0x80 >> (x % 8);
+    }
+
+private:
+    uint8_t* bitmap;
+};
+
+/**
+ * Remembers rasterized text so strings that are printed again and again, like on every page of a paged canvas,
+ * are only drawn glyph by glyph once.
+ * The pool for the bitmaps is allocated by reserve, without it nothing is cached.
+ * The cache starts over once it is full, the strings that matter come back on the next use.
+ */
+template <size_t MAX_RUNS>
+class TextCache {
+public:
+    ~TextCache()
+    {
+        delete[] pool;
+    }
+
+    /**
+     * Makes sure the pool has at least the given size, the cached runs are dropped if it grows.
+     * Returns false if there isn't enough memory, the old pool is kept then.
+     */
+    bool reserve(size_t size)
+    {
+        if (size <= poolSize) {
+            return true;
+        }
+
+        uint8_t* larger = new (std::nothrow) uint8_t[size];
+        if (larger == nullptr) {
+            return false;
+        }
+
+        delete[] pool;
+        pool = larger;
+        poolSize = size;
+        runCount = 0;
+        poolUsed = 0;
+        return true;
+    }
+
+    /**
+     * Frees the pool, nothing is cached until the next reserve.
+     */
+    void release()
+    {
+        delete[] pool;
+        pool = nullptr;
+        poolSize = 0;
+        runCount = 0;
+        poolUsed = 0;
+    }
+
+    size_t size() const
+    {
+        return poolSize;
+    }
+
+    /**
+     * Returns the run of the text in the given font and rotation of the canvas.
+     * The text is rasterized if it isn't cached yet, for that the font must be the current font of the canvas.
+     * Returns nullptr if the run is larger than the whole pool.
+     */
+    const TextRun* get(Adafruit_GFX& canvas, const GFXfont* font, const char* text)
+    {
+        if (poolSize == 0) {
+            return nullptr;
+        }
+
+        uint32_t textHash = hash(text);
+        uint8_t rotation = canvas.getRotation();
+        for (size_t i = 0; i < runCount; ++i) {
+            if (runs[i].hash == textHash && runs[i].font == font && runs[i].rotation == rotation && strcmp(this->text(runs[i]), text) == 0) {
+                return &runs[i];
+            }
+        }
+
+        int16_t x, y;
+        uint16_t width, height;
+        canvas.getTextBounds(text, 0, 0, &x, &y, &width, &height);
+        size_t size = TextRaster::size(width, height, rotation) + strlen(text) + 1;
+        if (size > poolSize) {
+            return nullptr;
+        }
+
+        if (runCount == MAX_RUNS || poolUsed + size > poolSize) {
+            runCount = 0;
+            poolUsed = 0;
+        }
+
+        TextRaster raster(pool + poolUsed, width, height, rotation);
+        raster.setFont(font);
+        raster.setTextWrap(false);
+        raster.setCursor(-x, -y);
+        raster.print(text);
+
+        TextRun& run = runs[runCount++];
+        run = { font, textHash, rotation, x, y, width, height, (int16_t)(raster.getCursorX() + x), (uint16_t)poolUsed };
+        strcpy((char*)pool + poolUsed + raster.size(), text);
+        poolUsed += size;
+        return &run;
+    }
+
+    const uint8_t* bitmap(const TextRun& run) const
+    {
+        return pool + run.offset;
+    }
+
+    const char* text(const TextRun& run) const
+    {
+        return (const char*)pool + run.offset + TextRaster::size(run.width, run.height, run.rotation);
+    }
+
+private:
+    // FNV-1a, so the text only has to be compared if the hash matches
+    static uint32_t hash(const char* text)
+    {
+        uint32_t hash = 2166136261;
+        for (; *text; ++text) {
+            hash = (hash ^ (uint8_t)*text) * 16777619;
+        }
+
+        return hash;
+    }
+
+    TextRun runs[MAX_RUNS];
+    size_t runCount = 0;
+    size_t poolUsed = 0;
+    size_t poolSize = 0;
+    uint8_t* pool = nullptr;
+};
@@ -0,0 +1,93 @@
+#include "timeSource.h"
+
+#include <string.h>
+
+#include "civil.h"
+
+// more than that isn't drift anymore, the clock was probably reset or set by something else
+#define TIME_SOURCE_MAX_DRIFT 50000
+
+static const char* const MONTH_NAMES[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+/**
+ * Reads exactly the given number of digits.
+ */
+static bool parseDigits(const char*& text, uint8_t digits, int32_t& value)
+{
+    value = 0;
+    for (uint8_t i = 0; i < digits; ++i, ++text) {
+        if (*text < '0' || *text > '9') {
+            return false;
+        }
+        value = value * 10 + (*text - '0');
+    }
+
+    return true;
+}
+
+static bool expect(const char*& text, char c)
+{
+    return *text++ == c;
+}
+
+time_t parseHttpDate(const char* text)
+{
+    // the week day is redundant, so it is only skipped
+    if (strlen(text) < 29 || text[3] != ',') {
+        return 0;
+    }
+    text += 4;
+
+    int32_t day, year, hour, minute, second;
+    if (!expect(text, ' ') || !parseDigits(text, 2, day) || !expect(text, ' ')) {
+        return 0;
+    }
+
+    uint8_t month = 0;
+    while (month < 12 && strncmp(text, MONTH_NAMES[month], 3) != 0) {
+        month++;
+    }
+    text += 3;
+
+    if (month == 12 || !expect(text, ' ') || !parseDigits(text, 4, year) || !expect(text, ' ')
+        || !parseDigits(text, 2, hour) || !expect(text, ':') || !parseDigits(text, 2, minute) || !expect(text, ':')
+        || !parseDigits(text, 2, second) || strcmp(text, " GMT") != 0) {
+        return 0;
+    }
+
+    if (day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+        return 0;
+    }
+
+    return (time_t)daysFromCivil(year, month + 1, day) * 86400 + hour * 3600 + minute * 60 + second;
+}
+
+void syncClock(ClockHistory& history, time_t serverTime, time_t clockTime)
+{
+    if (history.syncTime != 0 && clockTime > 1000 && serverTime - history.syncTime >= TIME_SOURCE_MIN_DRIFT_SECONDS) {
+        int64_t drift = ((int64_t)clockTime - serverTime) * 1000000 / (serverTime - history.syncTime);
+        if (drift > -TIME_SOURCE_MAX_DRIFT && drift < TIME_SOURCE_MAX_DRIFT) {
+            // the oscillator also depends on the temperature, so the drift is averaged over a few syncs
+            history.drift = history.driftCount == 0 ? drift : history.drift + (drift - history.drift) / 4;
+            history.driftCount += history.driftCount < UINT16_MAX;
+        }
+    }
+
+    history.syncTime = serverTime;
+}
+
+time_t correctClock(const ClockHistory& history, time_t clockTime)
+{
+    if (history.syncTime == 0 || clockTime < history.syncTime) {
+        return 0;
+    }
+
+    // the clock shows syncTime + elapsed * (1 + drift)
+    int64_t elapsed = clockTime - history.syncTime;
+    return history.syncTime + elapsed * 1000000 / (1000000 + history.drift);
+}
+
+uint32_t clockSeconds(const ClockHistory& history, uint32_t seconds)
+{
+    return (int64_t)seconds * (1000000 + history.drift) / 1000000;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// the drift is only measured over at least this long, the Date header has a resolution of one second
+#define TIME_SOURCE_MIN_DRIFT_SECONDS (12 * 3600)
+
+/**
+ * What is known about the RTC clock, kept in RTC memory.
+ * The clock is set to the time of a server whenever there is one and runs freely in between.
+ * The RTC slow clock that keeps the time in deep sleep is an RC oscillator that is off by a lot more than a crystal,
+ * but it is consistently off, so its drift is learned from one sync to the next and corrected in between.
+ */
+struct ClockHistory {
+    time_t syncTime; // when the clock was set the last time, 0 if it never was
+    int32_t drift; // how much the clock runs fast in parts per million, negative if it runs slow
+    uint16_t driftCount; // how many drift measurements went into drift
+};
+
+/**
+ * Parses the Date header of a http response, like "Sun, 06 Nov 1994 08:49:37 GMT" (RFC 7231 IMF-fixdate).
+ * Returns 0 if the text isn't a date in that format.
+ */
+time_t parseHttpDate(const char* text);
+
+/**
+ * Records that the clock, which showed clockTime, is now set to serverTime.
+ * The drift is measured if the clock ran freely long enough since the last sync,
+ * a clockTime of 0 means the clock wasn't set before, like after a power up.
+ */
+void syncClock(ClockHistory& history, time_t serverTime, time_t clockTime);
+
+/**
+ * Returns the clock time corrected by the drift since the last sync, 0 if the clock was never set.
+ */
+time_t correctClock(const ClockHistory& history, time_t clockTime);
+
+/**
+ * Returns how long to sleep on the drifting clock so the given number of real seconds pass.
+ */
+uint32_t clockSeconds(const ClockHistory& history, uint32_t seconds);
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Keeps the smallest items of everything that is added, up to the capacity of the provided array.
+ * Items are stored as a max heap, so finding out if an item is kept is O(1) and adding it is O(log n).
+ * Call sort() once everything is added to get the items in ascending order.
+ * Equal items are ordered by when they were added, like inserting them into a sorted list:
+ * the earlier ones are kept and come first.
+ */
+template <typename T, bool (*isGreaterThan)(const T&, const T&)>
+class TopList {
+public:
+    /**
+     * Uses the given arrays as storage, order gets the insertion order of each item.
+     * The first size items are already in the list and don't have to be in any particular order,
+     * equal ones count as added in the order of the array.
+     */
+    TopList(T* items, uint32_t* order, size_t capacity, size_t size = 0)
+        : items(items)
+        , order(order)
+        , capacity(capacity)
+        , count(size)
+        , added(size)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            order[i] = i;
+        }
+        for (size_t i = count / 2; i-- > 0;) {
+            siftDown(i, items[i], order[i], count);
+        }
+    }
+
+    /**
+     * Adds the item if it is smaller than the greatest item in the list or there is still space.
+     * The greatest item is dropped if the list is full.
+     * Returns false if the item was dropped itself.
+     */
+    bool add(const T& item)
+    {
+        // a later item is greater than an equal one that is already in the list
+        if (count < capacity) {
+            siftUp(count++, item, added++);
+            return true;
+        }
+
+        if (count == 0 || !isGreaterThan(items[0], item)) {
+            return false;
+        }
+
+        siftDown(0, item, added++, count);
+        return true;
+    }
+
+    /**
+     * Returns true if the item would not be added to the list.
+     * This allows to skip the work of creating items that are going to be dropped anyway.
+     */
+    bool rejects(const T& item) const
+    {
+        return count >= capacity && (count == 0 || !isGreaterThan(items[0], item));
+    }
+
+    /**
+     * The greatest item in the list, which is the next one to be dropped.
+     * Only valid if the list is not empty and sort() wasn't called.
+     */
+    const T& last() const { return items[0]; }
+
+    size_t size() const { return count; }
+    bool isFull() const { return count >= capacity; }
+
+    /**
+     * Sorts the items in ascending order.
+     * This destroys the heap, so nothing must be added afterwards.
+     */
+    void sort()
+    {
+        for (size_t end = count; end > 1; --end) {
+            T item = items[end - 1];
+            uint32_t itemOrder = order[end - 1];
+            items[end - 1] = items[0];
+            order[end - 1] = order[0];
+            siftDown(0, item, itemOrder, end - 1);
+        }
+    }
+
+private:
+    bool isGreater(const T& a, uint32_t aOrder, const T& b, uint32_t bOrder) const
+    {
+        return isGreaterThan(a, b) || (!isGreaterThan(b, a) && aOrder > bOrder);
+    }
+
+    void siftUp(size_t i, const T& item, uint32_t itemOrder)
+    {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!isGreater(item, itemOrder, items[parent], order[parent])) {
+                break;
+            }
+
+            items[i] = items[parent];
+            order[i] = order[parent];
+            i = parent;
+        }
+
+        items[i] = item;
+        order[i] = itemOrder;
+    }
+
+    void siftDown(size_t i, T item, uint32_t itemOrder, size_t end)
+    {
+        while (true) {
+            size_t child = i * 2 + 1;
+            if (child >= end) {
+                break;
+            }
+
+            if (child + 1 < end && isGreater(items[child + 1], order[child + 1], items[child], order[child])) {
+                child++;
+            }
+
+            if (!isGreater(items[child], order[child], item, itemOrder)) {
+                break;
+            }
+
+            items[i] = items[child];
+            order[i] = order[child];
+            i = child;
+        }
+
+        items[i] = item;
+        order[i] = itemOrder;
+    }
+
+    T* items;
+    uint32_t* order;
+    size_t capacity;
+    size_t count;
+    uint32_t added; // how many items were added so far, the insertion order of the next one
+};
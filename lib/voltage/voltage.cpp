@@ -0,0 +1,64 @@
+#include "voltage.h"
+
+// a measurement this far above the average is a charged or new battery
+#define VOLTAGE_CHARGE_MILLIVOLT 100
+
+uint32_t sampleVoltage(VoltageSource source, void* context, uint16_t count)
+{
+    uint32_t sum = 0, lowest = UINT32_MAX, highest = 0;
+    for (uint16_t i = 0; i < count; ++i) {
+        uint32_t sample = source(context);
+        sum += sample;
+        lowest = sample < lowest ? sample : lowest;
+        highest = sample > highest ? sample : highest;
+    }
+
+    if (count <= 2) {
+        return count > 0 ? sum / count : 0;
+    }
+
+    return (sum - lowest - highest) / (count - 2);
+}
+
+uint32_t updateVoltage(VoltageHistory& history, uint32_t millivolt, time_t now)
+{
+    uint32_t value = millivolt << VOLTAGE_FRACTION_BITS;
+    bool charged = history.average > 0 && millivolt > (history.average >> VOLTAGE_FRACTION_BITS) + VOLTAGE_CHARGE_MILLIVOLT;
+    if (history.average == 0 || charged) {
+        history = { value, 0, value, now > 1000 ? now : 0, now > 1000 ? now : 0 };
+        return millivolt;
+    }
+
+    if (now > 1000 && history.time != 0 && now > history.time) {
+        history.average -= (int64_t)history.slope * (now - history.time) / 86400;
+    }
+    history.time = now > 1000 ? now : 0;
+
+    // a quarter of every measurement, the noise of a single burst is a few millivolt
+    history.average += ((int32_t)value - (int32_t)history.average) / 4;
+
+    if (now <= 1000) {
+        return history.average >> VOLTAGE_FRACTION_BITS;
+    }
+    if (history.anchorTime == 0 || now < history.anchorTime) {
+        history.anchor = history.average;
+        history.anchorTime = now;
+    } else if (now - history.anchorTime >= 86400) {
+        int32_t slope = ((int64_t)history.anchor - (int64_t)history.average) * 86400 / (now - history.anchorTime);
+        history.slope = history.slope == 0 ? slope : history.slope + (slope - history.slope) / 4;
+        history.anchor = history.average;
+        history.anchorTime = now;
+    }
+
+    return history.average >> VOLTAGE_FRACTION_BITS;
+}
+
+int32_t voltageDaysLeft(const VoltageHistory& history, uint32_t emptyMillivolt)
+{
+    if (history.slope <= 0) {
+        return VOLTAGE_UNKNOWN_DAYS;
+    }
+
+    int32_t left = (int32_t)history.average - (int32_t)(emptyMillivolt << VOLTAGE_FRACTION_BITS);
+    return left > 0 ? left / history.slope : 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#define VOLTAGE_UNKNOWN_DAYS -1
+
+// the averages are kept with 4 fractional bits, so small daily changes don't get lost in rounding
+#define VOLTAGE_FRACTION_BITS 4
+
+/**
+ * The battery voltage of the last wake cycles, this is kept in RTC memory.
+ * The average smooths the noise of the ADC from one boot to the next,
+ * the slope is how fast the average falls and predicts when the battery is empty.
+ */
+struct VoltageHistory {
+    uint32_t average; // millivolt with VOLTAGE_FRACTION_BITS, 0 until the first measurement
+    int32_t slope; // millivolt per day with VOLTAGE_FRACTION_BITS, positive while discharging, 0 if unknown
+    uint32_t anchor; // the average at anchorTime, the slope is measured against it
+    time_t anchorTime; // 0 if the time was unknown
+    time_t time; // of the last measurement, 0 if unknown
+};
+
+/**
+ * Returns a single sample of the battery voltage in millivolt.
+ * On the device this reads the ADC, on the host it can be anything.
+ */
+typedef uint32_t (*VoltageSource)(void* context);
+
+/**
+ * Takes count samples back to back and returns their mean in millivolt.
+ * The lowest and highest sample are ignored since the ADC of the esp32 has the occasional spike.
+ */
+uint32_t sampleVoltage(VoltageSource source, void* context, uint16_t count = 64);
+
+/**
+ * Adds a measurement to the history and returns the new average in millivolt.
+ * The average is moved along the slope for the time since the last measurement first, so it doesn't lag behind.
+ * The slope is updated once a day passed since the last update of it.
+ * A jump upwards means the battery was charged, that starts the history over.
+ * Times below 1000 mean the clock isn't set, the slope stays as it is then.
+ */
+uint32_t updateVoltage(VoltageHistory& history, uint32_t millivolt, time_t now);
+
+/**
+ * Returns the predicted days until the average reaches emptyMillivolt,
+ * VOLTAGE_UNKNOWN_DAYS if the battery isn't known to discharge yet.
+ */
+int32_t voltageDaysLeft(const VoltageHistory& history, uint32_t emptyMillivolt);
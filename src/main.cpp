@@ -2,102 +2,291 @@
 #include <Arduino.h>
 #include <GxEPD2_3C.h>
 #include <HTTPClient.h>
+#include <esp_wifi.h>
+#include <memory>
+#include <mutex>
+#include <new>
 
 #include "../config.h"
+#include "canvas.h"
+#include "civil.h"
+#include "conditionalGet.h"
 #include "iCal.h"
+#include "inflate.h"
 #include "log.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "reconnect.h"
 #include "render.h"
+#include "schedule.h"
+#include "snapshot.h"
+#include "timeSource.h"
 #include "util.h"
+#include "voltage.h"
 
-GxEPD2_3C<GxEPD2_420c, GxEPD2_420c::HEIGHT> display(GxEPD2_420c(PIN_CS, PIN_DC, PIN_RST, PIN_BUSY));
-uint32_t millivolt = 0;
+// the whole frame takes 2 planes of 15 KB, with fewer rows per page it's drawn and sent to the panel page by page
+#ifndef DISPLAY_PAGE_HEIGHT
+#define DISPLAY_PAGE_HEIGHT GxEPD2_420c::HEIGHT
+#endif
+
+typedef Canvas3C<GxEPD2_420c::WIDTH, GxEPD2_420c::HEIGHT, DISPLAY_PAGE_HEIGHT> Canvas;
+GxEPD2_420c epd(PIN_CS, PIN_DC, PIN_RST, PIN_BUSY);
+Canvas display;
+uint32_t millivolt = 0; // the average over the last wake cycles
+int32_t daysLeft = VOLTAGE_UNKNOWN_DAYS;
+
+// below this the device only shows the voltage error, that's where the battery counts as empty
+const uint32_t EMPTY_MILLIVOLT = 3000;
+RTC_DATA_ATTR VoltageHistory voltageHistory;
+
+// the clock is set from the Date header of the calender downloads, NTP is only asked if that didn't work
+RTC_DATA_ATTR ClockHistory clockHistory;
+std::mutex clockLock;
+
+// digests of the bands that are currently on the panel, so only changed bands need a refresh
+RTC_DATA_ATTR uint32_t displayedBands[Canvas::MAX_BANDS];
+RTC_DATA_ATTR bool displayedValid = false;
+
+const char* const CALENDER_SOURCE_URLS[] = CALENDER_URLS;
+const uint16_t CALENDER_SOURCE_COLORS[] = CALENDER_COLORS;
+const size_t CALENDER_SOURCE_COUNT = sizeof(CALENDER_SOURCE_URLS) / sizeof(CALENDER_SOURCE_URLS[0]);
+
+// room for the summaries and a few bytes per entry, see snapshot.h
+const size_t CALENDER_SNAPSHOT_SIZE = 256 + CALENDER_SIZE * 8;
+
+struct CalenderSource {
+    uint8_t snapshot[CALENDER_SNAPSHOT_SIZE]; // the entries of the last download
+    HttpValidators validators; // of the snapshot
+};
+
+// the entries of a calender and the result of its update, only valid while awake
+struct CalenderList {
+    ICalEntry entries[CALENDER_SIZE];
+    size_t entryCount;
+    bool complete;
+    int httpStatus;
+    ICalResult result;
+};
 
+// the phases of the last wake cycles, to see which one got slower if the battery doesn't last as long anymore
+RTC_DATA_ATTR ProfileLog profileLog;
+
+// every calender survives deep sleep so it doesn't have to be downloaded again if it didn't change
+RTC_DATA_ATTR CalenderSource calenderSources[CALENDER_SOURCE_COUNT];
+RTC_DATA_ATTR int32_t lastDownloadDay = 0; // the local day all calenders were downloaded successfully
+CalenderList calenderLists[CALENDER_SOURCE_COUNT];
+
+const SleepPolicy SLEEP_POLICY = { SLEEP_MAX_DAYS, SLEEP_LOW_MILLIVOLT, SLEEP_LOW_DAYS };
+
+// the footer changes every night, so it can be left out when looking for changes of the frame
+#ifdef DISPLAY_IGNORE_FOOTER
+const int16_t FOOTER_BAND_HEIGHT = Canvas::BAND_HEIGHT;
+#else
+const int16_t FOOTER_BAND_HEIGHT = 1;
+#endif
+
+// all calenders merged
 ICalEntry calenderEntries[CALENDER_SIZE];
 size_t calenderEntryCount = 0;
 
-void enableWiFi(const char* ssid, const char* password);
+void initDisplay();
+void connectWiFi();
 void disableWiFi();
 time_t getTimestampBlocking();
-void updateCalender(const char* calenderUrl);
-void improveVoltage();
+time_t waitForTimestamp();
+void syncClockFromServer(const char* date);
+bool loadCalenderOffline();
+bool loadCalenderSnapshot(size_t index, int32_t firstDay);
+void updateCalender();
+void mergeCalender();
+void checkCalender();
+void updateCalenderSource(size_t index, void* context);
+uint32_t readVoltage(void* context);
+template <typename F>
+void updateDisplay(F draw);
 void hibernate(uint32_t seconds);
 void error(uint32_t seconds, const char* title, const char* format, ...);
 
 void setup()
 {
+    beginProfileCycle(profileLog);
     Serial.begin(115200);
     // Serial.setDebugOutput(true);
     // esp_log_level_set("*", ESP_LOG_INFO);
+    setTimeZone(GMT_OFFSET, DAYLIGHT_OFFSET);
 
 #ifdef PIN_VOLTAGE
     analogReadResolution(10);
     analogSetAttenuation(VOLTAGE_ATTEN);
-    millivolt = analogReadMilliVolts(PIN_VOLTAGE) * VOLTAGE_MOD;
-    if (millivolt < 2800) {
+    // a burst of samples takes a few milliseconds, the history smooths what is left of the noise
+    uint32_t measured = sampleVoltage(readVoltage, nullptr);
+    if (measured < 2800) {
         hibernate(0); // sleep forever
     }
-    createAsyncOneTimeTask("Voltage", improveVoltage);
-    LOGI("Voltage", "%u.%02u V", millivolt / 1000, millivolt % 1000);
-#endif
-
-    display.init(115200, false, 2, false);
-    display.setRotation(3);
-
-#ifdef PIN_VOLTAGE
-    if (millivolt < 3000) {
-        error(3600 * 24, "Voltage", "%u.%02u V", millivolt / 1000, millivolt % 1000);
+    millivolt = updateVoltage(voltageHistory, measured, correctClock(clockHistory, time(nullptr)));
+    daysLeft = voltageDaysLeft(voltageHistory, EMPTY_MILLIVOLT);
+    LOGI("Voltage", "%u mV measured, %u mV average, %d days left", measured, millivolt, (int)daysLeft);
+    if (measured < EMPTY_MILLIVOLT) {
+        initDisplay();
+        error(3600 * 24, "Voltage", "%u.%02u V", measured / 1000, measured % 1000);
     }
 #endif
 
 #ifdef PIN_LED
     pinMode(PIN_LED, OUTPUT);
 #endif
-    pinMode(PIN_CS, OUTPUT);
-    pinMode(PIN_DC, OUTPUT);
-    pinMode(PIN_RST, OUTPUT);
-    pinMode(PIN_BUSY, INPUT);
 }
 
+bool wifiConnected = false;
+
+// the access point of the last connection, so most wake ups don't have to scan and ask dhcp
+RTC_DATA_ATTR WiFiCache wifiCache;
+RTC_DATA_ATTR WiFiStats wifiStats;
+
+class EspWiFiRadio : public WiFiRadio {
+public:
+    bool connect(const WiFiCache* cache, uint32_t timeoutMillis) override;
+    void remember(WiFiCache& cache) override;
+
+    void disconnect() override
+    {
+        WiFi.disconnect();
+    }
+
+    uint32_t millis() override
+    {
+        return ::millis();
+    }
+};
+
+enum BootStage {
+    STAGE_DISPLAY,
+    STAGE_WIFI,
+    STAGE_CALENDER,
+    STAGE_COUNT,
+};
+
+// the panel reset doesn't need the network, so it runs while WiFi connects
+PipelineStage bootStages[STAGE_COUNT] = {
+    { "display", initDisplay, 0 },
+    { "wifi", connectWiFi, 0 },
+    { "calender", updateCalender, STAGE_BIT(STAGE_WIFI) },
+};
+
 void loop()
 {
 #ifdef PIN_LED
     digitalWrite(PIN_LED, HIGH);
 #endif
-    enableWiFi(WIFI_SSID, WIFI_PASSWORD);
-    configTime(GMT_OFFSET, DAYLIGHT_OFFSET, NTP_SERVER);
-    updateCalender(CALENDER_URL);
-    createAsyncOneTimeTask("disableWifi", disableWiFi);
+    // most nights the calenders from the last download are still good enough, then the network isn't needed at all
+    bool offline = loadCalenderOffline();
+    size_t stageCount = offline ? STAGE_WIFI : STAGE_COUNT;
+    runPipeline(bootStages, stageCount);
+    if (!offline) {
+        createAsyncOneTimeTask("disableWifi", disableWiFi);
+    }
 #ifdef PIN_LED
     digitalWrite(PIN_LED, LOW);
 #endif
 
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    uint32_t criticalPath = pipelineCriticalPath(bootStages, stageCount);
+    for (size_t i = 0; i < stageCount; ++i) {
+        auto& stage = bootStages[i];
+        LOGI("boot", "%-8s %5u - %5u ms%s", stage.name, stage.start / 1000, stage.end / 1000, criticalPath & STAGE_BIT(i) ? " critical" : "");
+    }
+#endif
+
+    // errors are reported once the pipeline is done, since error() needs the display and puts the device to sleep
+    if (!offline) {
+        if (!wifiConnected) {
+            error(3600, "WiFi", "SSID %s not reached", WIFI_SSID);
+        }
+        checkCalender();
+    }
+
     LOGI("main", "render calender with %u entries", calenderEntryCount);
     time_t timestamp = getTimestampBlocking();
-    display.fillScreen(GxEPD_WHITE);
-    display.setCursor(0, 0);
-    renderCalender(display, timestamp, calenderEntries, calenderEntryCount);
-
-    tm currentTime;
-    localtime_r(&timestamp, &currentTime);
-    unsigned sleepTime = 7200 // 2 hours after midnight
-        + (23 - currentTime.tm_hour) * 3600
-        + (59 - currentTime.tm_min) * 60
-        + (59 - currentTime.tm_sec);
-
-    renderFooter(display, timestamp, sleepTime, millivolt);
-    LOGI("main", "calender rendered, update screen");
-    display.display();
+    {
+        ProfileSpan render(PHASE_RENDER);
+        layoutCalender(calenderList, display.width(), calenderBottom(display.height(), FOOTER_BAND_HEIGHT), timestamp, calenderEntries, calenderEntryCount, CALENDER_SOURCE_COLORS);
+        reserveTextCache(display, calenderList);
+    }
+
+    // sleep through the nights on which the calender would look the same
+    unsigned sleepTime = sleepSeconds(timestamp, calenderEntries, calenderEntryCount, millivolt, daysLeft, SLEEP_POLICY);
+
+    // the layout is only done once, every page draws the same display list
+    LOGI("main", "calender laid out, update screen");
+    updateDisplay([&]() {
+        display.fillScreen(GxEPD_WHITE);
+        drawDisplayList(display, calenderList);
+#ifdef DISPLAY_PROFILE
+        renderFooter(display, timestamp, sleepTime, millivolt, daysLeft, &profileLog);
+#else
+        renderFooter(display, timestamp, sleepTime, millivolt, daysLeft);
+#endif
+    });
     hibernate(sleepTime);
 };
 
-void enableWiFi(const char* ssid, const char* password)
+void connectWiFi()
+{
+    EspWiFiRadio radio;
+    wifiConnected = reconnectWiFi(radio, wifiCache, wifiStats, correctClock(clockHistory, time(nullptr)));
+    auto& attempt = wifiStats.attempts[(wifiStats.attemptCount - 1) % RECONNECT_STATS_SIZE];
+    LOGI("WiFi", "%s %s after %u ms", attempt.kind == ATTEMPT_CACHED ? "cached" : "scan", attempt.connected ? "connected" : "failed", attempt.millis);
+}
+
+void initDisplay()
+{
+    epd.init(115200, false, 2, false);
+    display.setRotation(3);
+
+    pinMode(PIN_CS, OUTPUT);
+    pinMode(PIN_DC, OUTPUT);
+    pinMode(PIN_RST, OUTPUT);
+    pinMode(PIN_BUSY, INPUT);
+}
+
+bool EspWiFiRadio::connect(const WiFiCache* cache, uint32_t timeoutMillis)
 {
     WiFi.mode(WIFI_STA);
     WiFi.setHostname(WIFI_HOSTNAME);
-    WiFi.begin(ssid, password);
-    if (WiFi.waitForConnectResult() != WL_CONNECTED) {
-        error(3600, "WiFi", "SSID %s not reached", ssid);
+    if (cache != nullptr && cache->ip != 0) {
+        WiFi.config(cache->ip, cache->gateway, cache->subnet, cache->dns);
+    } else {
+        WiFi.config((uint32_t)0, (uint32_t)0, (uint32_t)0); // dhcp
+    }
+    if (cache != nullptr) {
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cache->channel, cache->bssid);
+    } else {
+        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
     }
+
+    // the access point knowing us is the end of the association, what follows is dhcp
+    uint32_t start = profileMicros();
+    wifi_ap_record_t accessPoint;
+    while (esp_wifi_sta_get_ap_info(&accessPoint) != ESP_OK && WiFi.status() != WL_NO_SSID_AVAIL && WiFi.status() != WL_CONNECT_FAILED && profileMicros() - start < timeoutMillis * 1000) {
+        delay(1);
+    }
+    addProfilePhase(PHASE_ASSOCIATE, start, profileMicros() - start);
+
+    ProfileSpan dhcp(PHASE_DHCP);
+    while (WiFi.status() != WL_CONNECTED && WiFi.status() != WL_NO_SSID_AVAIL && WiFi.status() != WL_CONNECT_FAILED && profileMicros() - start < timeoutMillis * 1000) {
+        delay(1);
+    }
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void EspWiFiRadio::remember(WiFiCache& cache)
+{
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    cache.ip = WiFi.localIP();
+    cache.gateway = WiFi.gatewayIP();
+    cache.subnet = WiFi.subnetMask();
+    cache.dns = WiFi.dnsIP();
 }
 
 void disableWiFi()
@@ -110,73 +299,392 @@ void disableWiFi()
     }
 }
 
+/**
+ * Sets the clock to the Date header of a response, the drift of the clock since the last time is learned on the way.
+ * This can be called from any task.
+ */
+void syncClockFromServer(const char* date)
+{
+    time_t serverTime = parseHttpDate(date);
+    if (serverTime == 0) {
+        // only the length, the header is gone before a deferred log is flushed
+        LOGI("Time", "no usable Date header of %u characters", strlen(date));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(clockLock);
+    time_t clockTime = time(nullptr);
+    syncClock(clockHistory, serverTime, clockTime > 1000 ? clockTime : 0);
+    timeval now = { serverTime, 0 };
+    settimeofday(&now, nullptr);
+    LOGI("Time", "clock was %d s off, drift %d ppm", (int)(clockTime - serverTime), (int)clockHistory.drift);
+}
+
 time_t lastTimestamp = 0;
-time_t getTimestampBlocking()
+time_t waitForTimestamp()
 {
-    if (lastTimestamp > 1000) {
-        return lastTimestamp;
+    time_t now = correctClock(clockHistory, time(nullptr));
+    if (now > 0) {
+        lastTimestamp = now;
+        return now;
     }
 
-    for (int i = 0; i < 200; ++i) {
-        time(&lastTimestamp);
-        if (lastTimestamp > 1000) {
-            return lastTimestamp;
+    // the clock got lost and no server sent a Date header, only then NTP is asked
+    static std::once_flag ntpStarted;
+    std::call_once(ntpStarted, []() {
+        configTime(GMT_OFFSET, DAYLIGHT_OFFSET, NTP_SERVER);
+    });
+
+    uint32_t ntpStart = profileMicros();
+    for (int i = 0; i < 2000; ++i) {
+        now = time(nullptr);
+        if (now > 1000) {
+            std::lock_guard<std::mutex> lock(clockLock);
+            if (clockHistory.syncTime == 0) {
+                syncClock(clockHistory, now, 0);
+            }
+            lastTimestamp = now;
+            addProfilePhase(PHASE_NTP, ntpStart, profileMicros() - ntpStart);
+            return now;
         }
         delay(1);
     }
 
-    error(3600, "NTP", "update though %s failed", NTP_SERVER);
     return 0;
 }
 
-void updateCalender(const char* calenderUrl)
+time_t getTimestampBlocking()
 {
-    LOGI("HTTP", "HTTP start %s", calenderUrl);
+    time_t timestamp = waitForTimestamp();
+    if (timestamp > 0) {
+        return timestamp;
+    }
 
-    HTTPClient http;
-    http.begin(calenderUrl);
-    int httpStatus = http.GET();
-    if (httpStatus != HTTP_CODE_OK) {
-        error(3600, "HTTP", "HTTP error %d %s", httpStatus, calenderUrl);
-    } else {
-        LOGI("HTTP", "HTTP ok %d %s", httpStatus, calenderUrl);
+    error(3600, "Time", "no Date header and no answer from %s", NTP_SERVER);
+    return 0;
+}
+
+/**
+ * Loads all calenders from their snapshots if the last download is recent enough.
+ * Returns false if the calenders have to be downloaded.
+ */
+bool loadCalenderOffline()
+{
+    time_t now = correctClock(clockHistory, time(nullptr));
+    if (now == 0) {
+        return false; // the time got lost, which happens on power up
     }
 
-    calenderEntryCount = 0;
-    auto earliestEntry = getTimestampBlocking() - 86400;
-    auto result = readICalStream(http.getStreamPtr(), calenderEntries, calenderEntryCount, CALENDER_SIZE, earliestEntry);
-    http.end();
+    int32_t downloadAge = localDays(now) - lastDownloadDay;
+    if (downloadAge < 0 || downloadAge >= CALENDER_DOWNLOAD_DAYS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < CALENDER_SOURCE_COUNT; ++i) {
+        if (!loadCalenderSnapshot(i, localDays(now))) {
+            LOGI("main", "snapshot of %s runs out, download it", CALENDER_SOURCE_URLS[i]);
+            return false;
+        }
+    }
+
+    LOGI("main", "render from the snapshots of %d days ago", (int)downloadAge);
+    mergeCalender();
+    return true;
+}
+
+/**
+ * Reads the snapshot of a calender and drops the entries before firstDay.
+ * Returns false if there is no valid snapshot or too few entries are left to last until the next download.
+ */
+bool loadCalenderSnapshot(size_t index, int32_t firstDay)
+{
+    auto& list = calenderLists[index];
+    uint8_t flags;
+    if (!readSnapshot(calenderSources[index].snapshot, CALENDER_SNAPSHOT_SIZE, list.entries, list.entryCount, CALENDER_SIZE, &flags)) {
+        return false;
+    }
+
+    list.complete = flags & SNAPSHOT_COMPLETE;
+    dropICalEntriesBefore(list.entries, list.entryCount, firstDay);
+    return list.complete || list.entryCount >= CALENDER_SIZE / 2;
+}
 
-    switch (result) {
-    case ICAL_END:
-        LOGI("HTTP", "calender read successfully");
-        break;
-    case ICAL_END_UNEXPECRED:
-    default:
-        error(3600, "HTTP", "connection ended unexpected: %s", calenderUrl);
-        break;
+/**
+ * Updates all calenders at the same time and merges them into calenderEntries.
+ * The wake time is that of the slowest calender instead of the sum of all of them.
+ */
+void updateCalender()
+{
+    if (!wifiConnected) {
+        return;
     }
+
+    runConcurrently(CALENDER_SOURCE_COUNT, updateCalenderSource, nullptr);
+    mergeCalender();
 }
 
-void improveVoltage()
+void mergeCalender()
 {
-    uint32_t sum = millivolt;
-    uint16_t samples = millivolt > 0 ? 1 : 0;
-    do {
-        sum += analogReadMilliVolts(PIN_VOLTAGE) * VOLTAGE_MOD;
-        millivolt = sum / ++samples;
-        delay(8);
-    } while (samples < 128);
-    LOGI("Voltage", "voltage measurement completed at %u", millivolt);
+    const ICalEntry* lists[CALENDER_SOURCE_COUNT];
+    size_t listSizes[CALENDER_SOURCE_COUNT];
+    for (size_t i = 0; i < CALENDER_SOURCE_COUNT; ++i) {
+        lists[i] = calenderLists[i].entries;
+        listSizes[i] = calenderLists[i].entryCount;
+    }
+
+    calenderEntryCount = mergeICalEntries(lists, listSizes, CALENDER_SOURCE_COUNT, calenderEntries, CALENDER_SIZE);
+}
+
+/**
+ * Reports the errors of updateCalender, which can't do it itself since error() puts the device to sleep.
+ */
+void checkCalender()
+{
+    time_t timestamp = getTimestampBlocking();
+    for (size_t i = 0; i < CALENDER_SOURCE_COUNT; ++i) {
+        auto& list = calenderLists[i];
+        auto url = CALENDER_SOURCE_URLS[i];
+        if (list.httpStatus != HTTP_CODE_OK && list.httpStatus != HTTP_CODE_NOT_MODIFIED) {
+            error(3600, "HTTP", "HTTP error %d %s", list.httpStatus, url);
+        } else if (list.result != ICAL_END) {
+            error(3600, "HTTP", "connection ended unexpected: %s", url);
+        }
+    }
+
+    lastDownloadDay = localDays(timestamp);
+}
+
+/**
+ * The download of one calender, conditionalGet decides which requests are sent and HttpResource sends them.
+ */
+class CalenderDownload : public HttpResource {
+public:
+    explicit CalenderDownload(size_t index)
+        : HttpResource(CALENDER_SOURCE_URLS[index])
+        , index(index)
+        , list(calenderLists[index])
+        // a year of events is mostly the same few lines, so it compresses 10 - 20 times
+        // the window is allocated before asking for gzip, without it the response is read as it is
+        , inflate(new (std::nothrow) InflateStream())
+    {
+        acceptGzip = inflate != nullptr;
+        list.result = ICAL_NEED_MORE;
+    }
+
+    int request(const char* ifNoneMatch, const char* ifModifiedSince) override
+    {
+        LOGI("HTTP", "HTTP start %s", url);
+
+        uint32_t requestStart = profileMicros();
+        list.httpStatus = HttpResource::request(ifNoneMatch, ifModifiedSince);
+        addProfilePhase(PHASE_HTTP, requestStart, profileMicros() - requestStart);
+        if (list.httpStatus > 0) {
+            syncClockFromServer(date().c_str());
+        }
+        auto timestamp = waitForTimestamp();
+        if (timestamp == 0) {
+            return 0;
+        }
+
+        today = localDays(timestamp);
+        return list.httpStatus;
+    }
+
+    bool loadCached() override
+    {
+        // the cached entries can only be reused if there are enough left after dropping the past ones
+        if (loadCalenderSnapshot(index, today)) {
+            LOGI("HTTP", "HTTP not modified, keep %u cached entries of %s", list.entryCount, url);
+            list.result = ICAL_END;
+            return true;
+        }
+
+        LOGI("HTTP", "HTTP not modified but only %u cached entries left of %s", list.entryCount, url);
+        return false;
+    }
+
+    bool readBody(HttpValidators& validators) override
+    {
+        LOGI("HTTP", "HTTP ok %d %s", list.httpStatus, url);
+
+        list.entryCount = 0;
+        // the parser reads while the body is still arriving, so the time blocked in reads is the download
+        ProfiledStream stream(http.getStreamPtr());
+        Stream* body = &stream;
+        bool compressed = isGzip();
+        if (compressed) {
+            inflate->begin(&stream);
+            body = inflate.get();
+        }
+        uint32_t readStart = profileMicros();
+        list.result = readICalStream(body, list.entries, list.entryCount, CALENDER_SIZE, today, index);
+        uint32_t readTime = profileMicros() - readStart;
+        addProfilePhase(PHASE_DOWNLOAD, readStart, stream.readMicros);
+        addProfilePhase(PHASE_PARSE, readStart, readTime - stream.readMicros);
+        if (compressed) {
+            LOGI("HTTP", "inflated %u compressed bytes of %s", inflate->compressedBytes(), url);
+            if (inflate->failed()) {
+                LOGE("HTTP", "gzip response is damaged: %s", url);
+            }
+        }
+        if (list.result != ICAL_END) {
+            return false;
+        }
+
+        LOGI("HTTP", "calender read successfully: %s", url);
+        list.complete = list.entryCount < CALENDER_SIZE;
+        if (writeSnapshot(calenderSources[index].snapshot, CALENDER_SNAPSHOT_SIZE, list.entries, list.entryCount, list.complete ? SNAPSHOT_COMPLETE : 0) == 0) {
+            LOGE("HTTP", "calender doesn't fit into the snapshot: %s", url);
+        }
+        keepValidators(validators);
+        return true;
+    }
+
+private:
+    size_t index;
+    CalenderList& list;
+    std::unique_ptr<InflateStream> inflate;
+    int32_t today = 0;
+};
+
+/**
+ * Updates a single calender, this runs in its own task.
+ */
+void updateCalenderSource(size_t index, void* context)
+{
+    CalenderDownload download(index);
+    conditionalGet(download, calenderSources[index].validators);
+}
+
+#ifdef PIN_VOLTAGE
+uint32_t readVoltage(void* context)
+{
+    return analogReadMilliVolts(PIN_VOLTAGE) * VOLTAGE_MOD;
+}
+#endif
+
+/**
+ * Sends the window of the panel (in panel coordinates) page by page.
+ * The page that is still in the buffer is sent first, all others are drawn again.
+ */
+template <typename F>
+void writeDisplayWindow(xy_t pos, xy_t size, F draw)
+{
+    uint16_t bufferedPage = display.getPageY() / DISPLAY_PAGE_HEIGHT;
+    uint16_t first = bufferedPage;
+    for (uint16_t i = 0; i < Canvas::PAGE_COUNT; ++i) {
+        uint16_t page = (first + i) % Canvas::PAGE_COUNT;
+        int16_t pageY = page * DISPLAY_PAGE_HEIGHT;
+        int16_t from = pos.y > pageY ? pos.y : pageY;
+        int16_t to = pos.y + size.y < pageY + DISPLAY_PAGE_HEIGHT ? pos.y + size.y : pageY + DISPLAY_PAGE_HEIGHT;
+        if (from >= to) {
+            continue;
+        }
+
+        if (page != bufferedPage) {
+            ProfileSpan render(PHASE_RENDER);
+            display.setPage(page);
+            draw();
+            bufferedPage = page;
+        }
+
+        ProfileSpan spi(PHASE_SPI);
+        epd.writeImagePart(display.blackBuffer, display.colorBuffer, pos.x, from - pageY, GxEPD2_420c::WIDTH, display.getPageRows(), pos.x, from, size.x, to - from);
+    }
+}
+
+/**
+ * Draws the frame with draw, which has to start with fillScreen, and refreshes the bands of the panel that changed.
+ * With a DISPLAY_PAGE_HEIGHT below the panel height, draw is called once per page to find the changes
+ * and once more for every other page that is sent.
+ */
+template <typename F>
+void updateDisplay(F draw)
+{
+    uint16_t bands = display.bandCount();
+#ifdef DISPLAY_IGNORE_FOOTER
+    // the calender ends at a band boundary, so every calender row is compared
+    uint16_t comparedBands = calenderBottom(display.height(), FOOTER_BAND_HEIGHT) / Canvas::BAND_HEIGHT;
+#else
+    uint16_t comparedBands = bands;
+#endif
+
+    uint32_t digests[Canvas::MAX_BANDS];
+    {
+        ProfileSpan render(PHASE_RENDER);
+        display.digestPages(digests, draw);
+    }
+
+    // find the range of bands that differ from what is on the panel
+    int16_t firstBand = -1, lastBand = -1;
+    for (uint16_t band = 0; band < comparedBands; ++band) {
+        if (!displayedValid || digests[band] != displayedBands[band]) {
+            firstBand = firstBand < 0 ? band : firstBand;
+            lastBand = band;
+        }
+    }
+
+    if (firstBand < 0) {
+        LOGI("main", "frame unchanged, skip display refresh");
+        return;
+    }
+
+    // a 3 color panel takes as long for a partial refresh as for a full one
+    // so the changes are combined into one window and a mostly changed frame is refreshed completely
+    uint16_t changedBands = lastBand - firstBand + 1;
+    if (!displayedValid || !GxEPD2_420c::hasPartialUpdate || changedBands * 4 > bands * 3) {
+        LOGI("main", "full display refresh");
+        writeDisplayWindow({ 0, 0 }, { GxEPD2_420c::WIDTH, GxEPD2_420c::HEIGHT }, draw);
+        ProfileSpan busy(PHASE_BUSY);
+        epd.refresh(false);
+        firstBand = 0;
+        lastBand = bands - 1;
+    } else {
+        xy_t pos = { 0, (int16_t)(firstBand * Canvas::BAND_HEIGHT) };
+        xy_t size = { display.width(), (int16_t)(changedBands * Canvas::BAND_HEIGHT) };
+        display.toPanel(pos, size);
+        LOGI("main", "partial display refresh of bands %d to %d", firstBand, lastBand);
+        writeDisplayWindow(pos, size, draw);
+        ProfileSpan busy(PHASE_BUSY);
+        epd.refresh(pos.x, pos.y, size.x, size.y);
+    }
+
+    epd.powerOff();
+    memcpy(&displayedBands[firstBand], &digests[firstBand], (lastBand - firstBand + 1) * sizeof(uint32_t));
+    displayedValid = true;
 }
 
 void hibernate(uint32_t seconds)
 {
+    addProfilePhase(PHASE_SLEEP, profileMicros(), 0);
+#ifdef PROFILE_DUMP
+    printProfileLog(profileLog, Serial);
+    printWiFiStats(wifiStats, Serial);
+    Serial.flush();
+#endif
+
     if (seconds > 0) {
         LOGI("main", "sleep %u seconds now!", seconds);
-        esp_deep_sleep(seconds * 1000000LL);
     } else {
         LOGI("main", "sleep forever now!");
+    }
+
+#ifdef LOG_DEFERRED
+    // with native usb Serial is only true if a host listens, a board with an uart bridge always sends
+    if (Serial) {
+#ifdef LOG_BINARY
+        dumpLog(Serial);
+#else
+        flushLog(Serial);
+#endif
+        Serial.flush();
+    }
+#endif
+
+    if (seconds > 0) {
+        // the timer runs on the same drifting clock as the time
+        esp_deep_sleep(clockSeconds(clockHistory, seconds) * 1000000LL);
+    } else {
         esp_deep_sleep_start(); // forever
     }
 }
@@ -194,12 +702,14 @@ void error(uint32_t seconds, const char* title, const char* format, ...)
     vsnprintf(messageBuffer, sizeof(messageBuffer) - 1, format, args);
     va_end(args);
 
-    LOGE(title, messageBuffer);
+    // the log is flushed by hibernate, before the buffer is gone
+    LOGE(title, "%s", LOG_KEPT(messageBuffer));
 
-    display.fillScreen(GxEPD_WHITE);
-    renderError(display, titleBuffer, messageBuffer);
-    renderFooter(display, lastTimestamp, seconds, millivolt);
-    display.display();
+    updateDisplay([&]() {
+        display.fillScreen(GxEPD_WHITE);
+        renderError(display, titleBuffer, messageBuffer);
+        renderFooter(display, lastTimestamp, seconds, millivolt);
+    });
 
     hibernate(seconds);
 }
\ No newline at end of file